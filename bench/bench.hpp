@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fmt/format.h>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace httplib::bench {
+
+using namespace std::chrono_literals;
+
+// keeps the compiler from dropping a computation whose result is otherwise unused.
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+    static const volatile void* sink;
+    sink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+// operator new calls of the whole process so far, the suites look at the difference around
+// their own loop.
+std::uint64_t allocations();
+
+inline void report(std::string_view name, double value, std::string_view unit)
+{
+    fmt::print("  {:<52} {:>14.2f} {}\n", name, value, unit);
+    std::fflush(stdout);
+}
+
+// calls `func` in a loop, doubling the iteration count until a run lasts at least `min_time`,
+// and reports the time per call of that last run.
+template<typename Func>
+double measure(std::string_view name,
+               Func&& func,
+               std::chrono::steady_clock::duration min_time = 200ms)
+{
+    for (int i = 0; i < 16; ++i)
+        func();
+
+    std::uint64_t iterations = 1;
+    for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < iterations; ++i)
+            func();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        if (elapsed >= min_time || iterations >= (std::uint64_t(1) << 40)) {
+            double ns = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+            report(name, ns, "ns/op");
+            return ns;
+        }
+        iterations *= 2;
+    }
+}
+
+using suite_func = void (*)();
+
+inline std::map<std::string, suite_func>& suites()
+{
+    static std::map<std::string, suite_func> instance;
+    return instance;
+}
+
+struct registrar
+{
+    registrar(const char* name, suite_func func) { suites().emplace(name, func); }
+};
+
+} // namespace httplib::bench
+
+#define HTTPLIB_BENCH(name)                                                                        \
+    static void bench_##name();                                                                    \
+    static const httplib::bench::registrar bench_registrar_##name(#name, &bench_##name);           \
+    static void bench_##name()
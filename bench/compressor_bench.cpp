@@ -0,0 +1,79 @@
+#include "bench.hpp"
+#ifdef HTTPLIB_ENABLED_COMPRESS
+#include "body/compressor.hpp"
+#include <string>
+
+using namespace httplib;
+
+namespace {
+
+// json-ish records, about as compressible as a typical api response.
+std::string make_payload(std::size_t size)
+{
+    std::string data;
+    std::uint32_t seed = 12345;
+    while (data.size() < size) {
+        seed = seed * 1664525 + 1013904223;
+        data += fmt::format(R"({{"id":{},"name":"user{}","score":{},"active":{}}},)",
+                            seed % 100000,
+                            seed % 977,
+                            (seed >> 8) % 1000,
+                            seed & 1 ? "true" : "false");
+    }
+    data.resize(size);
+    return data;
+}
+
+std::string encode(const std::string& encoding, const std::string& data)
+{
+    auto compressor = body::compressor_factory::instance().create(encoding);
+    compressor->init(body::compressor::mode::encode);
+    compressor->write(net::buffer(data), false);
+    auto buffer = compressor->buffer();
+    return std::string(static_cast<const char*>(buffer.data()), buffer.size());
+}
+
+// one message per call, the whole body in a single write as for a buffered response.
+void codec(const std::string& encoding, const std::string& data)
+{
+    auto encoded = encode(encoding, data);
+    auto size    = data.size();
+
+    auto run = [&](body::compressor::mode mode, const std::string& input) {
+        auto compressor = body::compressor_factory::instance().create(encoding);
+        compressor->init(mode);
+        compressor->write(net::buffer(input), false);
+        bench::do_not_optimize(compressor->buffer().size());
+    };
+
+    for (auto mode : {body::compressor::mode::encode, body::compressor::mode::decode}) {
+        bool encoding_mode = mode == body::compressor::mode::encode;
+        auto& input        = encoding_mode ? data : encoded;
+        auto name =
+            fmt::format("{} {} {}KB", encoding, encoding_mode ? "encode" : "decode", size / 1024);
+
+        auto ns = bench::measure(name, [&]() { run(mode, input); });
+        bench::report(fmt::format("{}, throughput", name), size * 1e3 / ns, "MB/s");
+
+        auto before = bench::allocations();
+        for (int i = 0; i < 100; ++i)
+            run(mode, input);
+        bench::report(fmt::format("{}, allocations", name),
+                      (bench::allocations() - before) / 100.0,
+                      "allocs/msg");
+    }
+}
+
+} // namespace
+
+// each codec on a small and a large response. zlib and zstd contexts come from the per thread
+// pool, what is left per message is the compressor and its output buffer. The codecs allocate
+// their state with malloc, which the allocation count does not see.
+HTTPLIB_BENCH(compressor)
+{
+    for (const auto& encoding : body::compressor_factory::instance().supported_encoding()) {
+        for (std::size_t size : {4 * 1024, 256 * 1024})
+            codec(encoding, make_payload(size));
+    }
+}
+#endif
@@ -0,0 +1,103 @@
+#include "bench.hpp"
+#include "server/file_reader.hpp"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <fstream>
+#include <vector>
+
+using namespace httplib;
+
+namespace {
+
+using file_info = body::file_body::file_info;
+
+constexpr std::size_t file_size = 16 * 1024 * 1024;
+
+// reads the whole file chunk by chunk with `read` until that took at least 200ms, returns
+// the time per chunk.
+template<typename Read>
+double read_file(net::io_context& ioc, std::size_t chunk_size, Read&& read)
+{
+    std::vector<char> chunk(chunk_size);
+    double ns = 0;
+
+    net::co_spawn(
+        ioc,
+        [&]() -> net::awaitable<void> {
+            std::uint64_t chunks = 0;
+            auto start           = std::chrono::steady_clock::now();
+            auto elapsed         = std::chrono::steady_clock::duration::zero();
+            while (elapsed < std::chrono::milliseconds(200)) {
+                for (std::uint64_t offset = 0; offset < file_size; offset += chunk_size) {
+                    boost::system::error_code ec;
+                    auto bytes = co_await read(offset, net::buffer(chunk), ec);
+                    if (ec || bytes == 0)
+                        throw boost::system::system_error(ec);
+                    ++chunks;
+                }
+                elapsed = std::chrono::steady_clock::now() - start;
+            }
+            ns = std::chrono::duration<double, std::nano>(elapsed).count() / chunks;
+        },
+        [](std::exception_ptr e) {
+            if (e)
+                std::rethrow_exception(e);
+        });
+    ioc.restart();
+    ioc.run();
+    return ns;
+}
+
+} // namespace
+
+// a file in the page cache, read in the chunks a response is written in: by file_reader, which
+// reads cached data in place, and by a pread on a thread pool for every chunk, what it did
+// before and still does for data that is not cached.
+HTTPLIB_BENCH(file_reader)
+{
+    auto path = fs::temp_directory_path() / "httplib_bench_file";
+    {
+        std::ofstream file(path, std::ios::binary);
+        std::vector<char> data(file_size, 'x');
+        file.write(data.data(), data.size());
+    }
+
+    boost::system::error_code ec;
+    std::shared_ptr<const file_info> info = file_info::open(path, ec);
+    if (ec) {
+        fmt::print(stderr, "open {} failed: {}\n", path.string(), ec.message());
+        return;
+    }
+
+    net::io_context ioc;
+    net::thread_pool pool(2);
+    server::file_reader reader(ioc.get_executor(), info);
+
+    for (std::size_t chunk_size : {16 * 1024, 256 * 1024}) {
+        auto report = [&](std::string_view mode, double ns) {
+            auto name = fmt::format("{}, {}KB chunks", mode, chunk_size / 1024);
+            bench::report(name, ns, "ns/chunk");
+            bench::report(fmt::format("{}, throughput", name), chunk_size * 1e3 / ns, "MB/s");
+        };
+
+        report("file_reader",
+               read_file(ioc, chunk_size, [&](auto offset, auto buffer, auto& ec) {
+                   return reader.async_read_some_at(offset, buffer, ec);
+               }));
+
+        report("pread on a thread pool",
+               read_file(ioc, chunk_size, [&](auto offset, auto buffer, auto& ec) {
+                   return net::co_spawn(
+                       pool,
+                       [=, &ec]() -> net::awaitable<std::size_t> {
+                           co_return info->read_at(offset, buffer.data(), buffer.size(), ec);
+                       },
+                       net::use_awaitable);
+               }));
+    }
+
+    std::error_code remove_ec;
+    fs::remove(path, remove_ec);
+}
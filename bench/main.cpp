@@ -0,0 +1,55 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+static std::atomic_uint64_t allocation_count = 0;
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (auto* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+std::uint64_t httplib::bench::allocations()
+{
+    return allocation_count.load(std::memory_order_relaxed);
+}
+
+// httplib_bench [suite...]: runs the named suites, or all of them.
+int main(int argc, char** argv)
+{
+    auto& suites = httplib::bench::suites();
+
+    if (argc > 1 && std::string_view(argv[1]) == "--list") {
+        for (const auto& [name, func] : suites)
+            fmt::print("{}\n", name);
+        return 0;
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        if (!suites.contains(argv[i])) {
+            fmt::print(stderr, "unknown suite: {}\n", argv[i]);
+            return 1;
+        }
+    }
+
+    for (const auto& [name, func] : suites) {
+        if (argc > 1 && std::find(argv + 1, argv + argc, name) == argv + argc)
+            continue;
+
+        fmt::print("{}\n", name);
+        func();
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "bench.hpp"
+#include "httplib/server/request.hpp"
+#include <boost/beast/http/parser.hpp>
+
+using namespace httplib;
+using namespace std::string_view_literals;
+
+namespace {
+
+constexpr auto browser_get = "GET /api/v1/users/42/orders HTTP/1.1\r\n"
+                             "Host: example.com\r\n"
+                             "User-Agent: Mozilla/5.0 (X11; Linux x86_64) Gecko/20100101\r\n"
+                             "Accept: text/html,application/xhtml+xml,application/xml;q=0.9\r\n"
+                             "Accept-Language: en-US,en;q=0.5\r\n"
+                             "Accept-Encoding: gzip, deflate, br\r\n"
+                             "Connection: keep-alive\r\n"
+                             "Cookie: session=0123456789abcdef; theme=dark\r\n"
+                             "Cache-Control: max-age=0\r\n"
+                             "\r\n"sv;
+
+constexpr auto query_get = "GET /search?q=hello%20world&page=2&sort=desc HTTP/1.1\r\n"
+                           "Host: example.com\r\n"
+                           "Accept: */*\r\n"
+                           "\r\n"sv;
+
+// what the connection does for a request without a body: parse the header, move it out of
+// the parser into a request.
+template<typename Use>
+void parse_request(std::string_view name, std::string_view data, Use&& use)
+{
+    static const tcp::endpoint local(net::ip::make_address("127.0.0.1"), 80);
+    static const tcp::endpoint remote(net::ip::make_address("127.0.0.1"), 50000);
+
+    auto run = [&]() {
+        http::request_parser<http::empty_body> parser;
+        parser.header_limit(std::numeric_limits<std::uint32_t>::max());
+        parser.body_limit(std::numeric_limits<unsigned long long>::max());
+
+        boost::system::error_code ec;
+        parser.put(net::buffer(data), ec);
+
+        server::request req(local, remote, parser.release());
+        use(req);
+    };
+
+    bench::measure(fmt::format("{}, time", name), run);
+
+    auto before = bench::allocations();
+    for (int i = 0; i < 1000; ++i)
+        run();
+    auto count = bench::allocations() - before;
+    bench::report(fmt::format("{}, allocations", name), count / 1000.0, "allocs/req");
+}
+
+} // namespace
+
+HTTPLIB_BENCH(request)
+{
+    parse_request("browser GET, 8 headers", browser_get, [](server::request& req) {
+        bench::do_not_optimize(req.path());
+    });
+    parse_request("GET with query, 3 params read", query_get, [](server::request& req) {
+        bench::do_not_optimize(req.path());
+        bench::do_not_optimize(req.query_params());
+    });
+}
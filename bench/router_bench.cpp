@@ -0,0 +1,78 @@
+#include "bench.hpp"
+#include "server/router_impl.h"
+#include <string>
+#include <vector>
+
+using namespace httplib;
+
+namespace {
+
+constexpr int resources = 20;
+
+// 20 resources with 10 static actions, 4 actions under an id param and one regex file route
+// each, plus a wildcard: 301 routes.
+void add_routes(server::router_impl& router)
+{
+    auto handler = [](server::request& req, server::response& resp) { };
+    for (int r = 0; r < resources; ++r) {
+        for (int a = 0; a < 10; ++a)
+            router.set_http_handler<http::verb::get>(fmt::format("/api/r{}/a{}", r, a), handler);
+        for (int a = 0; a < 4; ++a)
+            router.set_http_handler<http::verb::get>(fmt::format("/api/r{}/:id/p{}", r, a),
+                                                     handler);
+        router.set_http_handler<http::verb::get>(
+            fmt::format("/files/r{}/{{name:^[a-z]+\\.txt$}}", r), handler);
+    }
+    router.set_http_handler<http::verb::get>("/static/*", handler);
+}
+
+void match(const server::router_impl& router,
+           std::string_view name,
+           const std::vector<std::string>& paths,
+           bool found = true)
+{
+    for (const auto& path : paths) {
+        if (bool(router.match(http::verb::get, path).entry) != found) {
+            fmt::print(stderr, "{}: unexpected match result for {}\n", name, path);
+            return;
+        }
+    }
+
+    std::size_t i = 0;
+    bench::measure(name, [&]() {
+        auto route = router.match(http::verb::get, paths[i++ % paths.size()]);
+        bench::do_not_optimize(route);
+    });
+
+    auto before = bench::allocations();
+    for (const auto& path : paths)
+        bench::do_not_optimize(router.match(http::verb::get, path));
+    bench::report(fmt::format("{}, allocations", name),
+                  double(bench::allocations() - before) / paths.size(),
+                  "allocs/op");
+}
+
+} // namespace
+
+// match() on a frozen router of a few hundred routes, one kind of path at a time.
+HTTPLIB_BENCH(router)
+{
+    server::router_impl router;
+    add_routes(router);
+    router.freeze();
+
+    std::vector<std::string> statics, params, regexes, wildcards, misses;
+    for (int r = 0; r < resources; ++r) {
+        statics.push_back(fmt::format("/api/r{}/a{}", r, r % 10));
+        params.push_back(fmt::format("/api/r{}/{}/p{}", r, 1000 + r, r % 4));
+        regexes.push_back(fmt::format("/files/r{}/report.txt", r));
+        wildcards.push_back(fmt::format("/static/css/site{}.css", r));
+        misses.push_back(fmt::format("/api/r{}/a{}/unknown", r, r % 10));
+    }
+
+    match(router, "static, 301 routes", statics);
+    match(router, "param, 301 routes", params);
+    match(router, "regex, 301 routes", regexes);
+    match(router, "wildcard, 301 routes", wildcards);
+    match(router, "not found, 301 routes", misses, false);
+}
@@ -0,0 +1,59 @@
+#include "bench.hpp"
+#include "server/router_impl.h"
+#include "server/segment_regex.hpp"
+#include <regex>
+#include <vector>
+
+using namespace httplib;
+using namespace std::string_view_literals;
+
+namespace {
+
+// one `{name:regex}` segment against the values a route sees, through segment_regex and
+// through std::regex_match as the router did before.
+void segment(std::string_view name,
+             std::string_view pattern,
+             std::initializer_list<std::string_view> values)
+{
+    server::segment_regex native(pattern);
+    std::regex regex(pattern.begin(), pattern.end());
+
+    std::vector<std::string_view> inputs(values);
+    for (auto value : inputs) {
+        if (native.match(value) != std::regex_match(value.begin(), value.end(), regex)) {
+            fmt::print(stderr, "{}: segment_regex and std::regex disagree on {}\n", name, value);
+            return;
+        }
+    }
+
+    std::size_t i = 0;
+    auto mode     = native.is_native() ? "native" : "fallback";
+    bench::measure(fmt::format("{} segment_regex ({})", name, mode), [&]() {
+        bench::do_not_optimize(native.match(inputs[i++ % inputs.size()]));
+    });
+    bench::measure(fmt::format("{} std::regex", name), [&]() {
+        auto value = inputs[i++ % inputs.size()];
+        bench::do_not_optimize(std::regex_match(value.begin(), value.end(), regex));
+    });
+}
+
+} // namespace
+
+HTTPLIB_BENCH(segment_regex)
+{
+    segment(R"(^\d+$)", R"(^\d+$)", {"10000"sv, "42"sv, "1234567890"sv, "10000.0"sv});
+    segment("[a-z0-9-]+", "[a-z0-9-]+", {"my-first-post"sv, "release-2024"sv, "Upper"sv});
+    segment("uuid",
+            "[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}",
+            {"123e4567-e89b-12d3-a456-426614174000"sv, "123e4567-e89b-12d3-a456"sv});
+    segment("(jpg|png|gif)", "(jpg|png|gif)", {"png"sv, "webp"sv});
+
+    // the whole route of the example server, /regex/{id:^\d+$}.
+    server::router_impl router;
+    router.set_http_handler<http::verb::get>(
+        R"(/regex/{id:^\d+$})", [](server::request& req, server::response& resp) { });
+    router.freeze();
+    bench::measure("router match /regex/10000", [&]() {
+        bench::do_not_optimize(router.match(http::verb::get, "/regex/10000"));
+    });
+}
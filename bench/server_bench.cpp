@@ -0,0 +1,107 @@
+#include "bench.hpp"
+#include "httplib/server/request.hpp"
+#include "httplib/server/response.hpp"
+#include "httplib/server/router.hpp"
+#include "httplib/server/server.hpp"
+#include <boost/asio/thread_pool.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/tcp_stream.hpp>
+#include <boost/beast/http/empty_body.hpp>
+#include <boost/beast/http/read.hpp>
+#include <boost/beast/http/string_body.hpp>
+#include <boost/beast/http/write.hpp>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <vector>
+
+using namespace httplib;
+using namespace std::string_view_literals;
+
+namespace {
+
+// keep-alive GET clients, each on its own thread and connection, for `duration`. Returns the
+// number of responses received.
+std::uint64_t run_clients(const tcp::endpoint& endp,
+                          std::size_t clients,
+                          std::chrono::steady_clock::duration duration)
+{
+    std::atomic_bool stop = false;
+    std::atomic_uint64_t total = 0;
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < clients; ++i) {
+        threads.emplace_back([&]() {
+            net::io_context ioc;
+            beast::tcp_stream stream(ioc);
+            boost::system::error_code ec;
+            stream.connect(endp, ec);
+            if (ec)
+                return;
+
+            http::request<http::empty_body> req(http::verb::get, "/plaintext", 11);
+            req.set(http::field::host, "127.0.0.1");
+            req.keep_alive(true);
+
+            beast::flat_buffer buffer;
+            std::uint64_t count = 0;
+            while (!stop) {
+                http::write(stream, req, ec);
+                if (ec)
+                    break;
+                http::response<http::string_body> resp;
+                http::read(stream, buffer, resp, ec);
+                if (ec)
+                    break;
+                ++count;
+            }
+            total += count;
+        });
+    }
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto& thread : threads)
+        thread.join();
+    return total;
+}
+
+// requests per second of one server: `threads` workers on a shared io_context, or `shards`
+// SO_REUSEPORT acceptors with one io_context each when non-zero.
+double plaintext_throughput(std::size_t threads, std::size_t shards, std::size_t clients)
+{
+    net::thread_pool pool(threads);
+    server::http_server svr(pool.get_executor());
+    svr.get_logger()->set_level(spdlog::level::warn);
+    if (shards)
+        svr.set_reuse_port_shards(shards);
+
+    svr.router().set_http_handler<http::verb::get>(
+        "/plaintext", [](server::request& req, server::response& resp) {
+            resp.set_string_content("hello world"sv, "text/plain");
+        });
+    svr.listen("127.0.0.1", 0);
+    svr.async_run();
+
+    auto duration = std::chrono::seconds(2);
+    auto count    = run_clients(svr.local_endpoint(), clients, duration);
+
+    net::post(pool, [&svr]() { svr.stop(); });
+    pool.join();
+    return count / std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+// a single io_context served by n threads against n reuse-port shards, hello world over
+// keep-alive connections from 4 client threads per server thread.
+HTTPLIB_BENCH(server)
+{
+    std::size_t n = std::max(1u, std::thread::hardware_concurrency());
+
+    bench::report(fmt::format("plaintext, 1 io_context x {} threads", n),
+                  plaintext_throughput(n, 0, n * 4),
+                  "req/s");
+    bench::report(fmt::format("plaintext, {} reuse-port shards", n),
+                  plaintext_throughput(1, n, n * 4),
+                  "req/s");
+}
@@ -0,0 +1,76 @@
+#include "bench.hpp"
+#include "httplib/config.hpp"
+#include "util/timer_wheel.hpp"
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <vector>
+
+using namespace httplib;
+
+namespace {
+
+constexpr std::size_t connections = 10000;
+
+class connection : public util::timer_wheel::entry
+{
+protected:
+    void on_expired() override { }
+};
+
+} // namespace
+
+// what a connection pays to guard one read with a deadline: arm it before, disarm it after.
+// The wheel stores two atomics, a per-operation timer queues a wait and a cancellation whose
+// handler the io_context has to run.
+HTTPLIB_BENCH(timer)
+{
+    {
+        util::timer_wheel wheel;
+        std::vector<connection> entries(connections);
+        for (auto& e : entries) {
+            e.expires_after(std::chrono::seconds(30));
+            wheel.add(e);
+        }
+
+        std::size_t i = 0;
+        bench::measure("timer_wheel arm + disarm, 10000 connections", [&]() {
+            auto& e = entries[i++ % connections];
+            e.expires_after(std::chrono::seconds(30));
+            e.expires_never();
+        });
+
+        // the periodic cost instead: idle entries are re-parked once per revisit interval.
+        auto now = util::timer_wheel::clock::now();
+        bench::measure("timer_wheel advance one tick, 10000 connections", [&]() {
+            now += wheel.tick();
+            bench::do_not_optimize(wheel.advance(now));
+        });
+
+        for (auto& e : entries)
+            wheel.remove(e);
+    }
+    {
+        net::io_context ioc;
+        std::vector<net::steady_timer> timers;
+        timers.reserve(connections);
+        for (std::size_t i = 0; i < connections; ++i) {
+            timers.emplace_back(ioc);
+            timers.back().expires_after(std::chrono::seconds(30));
+            timers.back().async_wait([](boost::system::error_code) { });
+        }
+
+        std::size_t i = 0;
+        bench::measure("steady_timer arm + disarm, 10000 connections", [&]() {
+            auto& t = timers[i++ % connections];
+            t.expires_after(std::chrono::seconds(30));
+            t.async_wait([](boost::system::error_code) { });
+            t.cancel();
+            if (i % 64 == 0)
+                ioc.poll();
+        });
+
+        for (auto& t : timers)
+            t.cancel();
+        ioc.poll();
+    }
+}
@@ -4,6 +4,7 @@
 #include "httplib/body/form_data_body.hpp"
 #include "httplib/body/json_body.hpp"
 #include "httplib/body/query_params_body.hpp"
+#include "httplib/body/shared_body.hpp"
 #include "httplib/body/string_body.hpp"
 
 namespace httplib::body {
@@ -68,7 +69,8 @@ struct any_body
                                      json_body,
                                      form_data_body,
                                      file_body,
-                                     query_params_body>;
+                                     query_params_body,
+                                     shared_body>;
 
     class writer
     {
@@ -4,44 +4,79 @@
 #include <boost/beast/core/file.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/beast/http/message.hpp>
-#include <fstream>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <memory>
 
 namespace httplib::body {
 struct file_body
 {
+    // an open file and what its responses are built from. Immutable once opened, so it can be
+    // shared by every response serving the file: reads are positional.
+    struct file_info
+    {
+        beast::file file;
+        std::uint64_t size          = 0;
+        std::time_t last_write_time = 0;
+        std::string etag;
+        std::string last_modified;
+        std::string content_type;
+        // set for a precompressed variant, the content is sent as it is stored.
+        std::string content_encoding;
+        // a small hot file can be held in memory, its responses then point into `content`.
+        bool loaded = false;
+        std::string content;
+
+        // fails with no_such_file_or_directory for anything but a regular file. A precompressed
+        // variant ("app.js.br") is opened with its encoding, it takes the mime type of the
+        // original and an etag of its own.
+        static std::shared_ptr<file_info> open(const fs::path& path,
+                                               boost::system::error_code& ec,
+                                               std::string_view content_encoding = {});
+        // reads the whole file into `content`, before the info is shared.
+        void load(boost::system::error_code& ec);
+
+        std::size_t read_at(std::uint64_t offset,
+                            void* buffer,
+                            std::size_t n,
+                            boost::system::error_code& ec) const;
+    };
+
+    // a request body received to disk (body_mode::file). The reader creates the file in
+    // `directory`; it is removed with the last reference unless the handler moved it away.
+    struct upload_file
+    {
+        fs::path directory;
+        // O_DIRECT where the file system takes it: the upload bypasses the page cache.
+        bool direct_io = false;
+        // a body longer than this fails with errc::file_too_large.
+        std::uint64_t limit = (std::numeric_limits<std::uint64_t>::max)();
+
+        fs::path path;
+        std::uint64_t size = 0;
+
+        upload_file()                              = default;
+        upload_file(const upload_file&)            = delete;
+        upload_file& operator=(const upload_file&) = delete;
+        ~upload_file();
+
+        // renames the file to `target` (same file system), which owns it from then on.
+        void move_to(const fs::path& target, std::error_code& ec);
+    };
+
     struct value_type
     {
         html::http_ranges ranges;
         std::string content_type;
         std::string boundary;
+        std::shared_ptr<const file_info> info;
+        std::shared_ptr<upload_file> upload;
 
-        std::size_t file_size() const { return file_size_; }
-
-        void seekg(std::ios::off_type _Off, std::ios_base::seekdir _Way = std::ios::cur)
-        {
-            file_.seekg(_Off, _Way);
-        }
-        std::size_t read(void* buffer, std::size_t n)
-        {
-            file_.read((char*)buffer, n);
-            return file_.gcount();
-        }
-        void open(const fs::path& path,
-                  std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out)
-        {
-            file_size_ = 0;
-            file_.open(path, mode);
-            if (file_) {
-                file_.seekg(0, std::ios::end);
-                file_size_ = file_.tellg();
-                file_.seekg(0, std::ios::beg);
-            }
-        }
-        bool is_open() const { return file_.is_open(); }
-
-    private:
-        std::fstream file_;
-        std::size_t file_size_ = 0;
+        std::size_t file_size() const { return info ? info->size : 0; }
+        bool is_open() const { return info && info->file.is_open(); }
+        // the os handle, lets plain connections sendfile() the content.
+        auto native_handle() const { return info->file.native_handle(); }
     };
 
     class writer
@@ -55,6 +90,10 @@ struct file_body
 
         boost::optional<std::pair<const_buffers_type, bool>> get(boost::system::error_code& ec);
 
+    private:
+        // the next piece of [pos_, end), empty once it is done.
+        net::const_buffer read_content(std::uint64_t end, boost::system::error_code& ec);
+
     private:
         value_type& body_;
 
@@ -69,7 +108,6 @@ struct file_body
         };
         step step_ = step::header;
         char buf_[BOOST_BEAST_FILE_BUFFER_SIZE];
-        std::size_t file_size_;
     };
     //--------------------------------------------------------------------------
 
@@ -85,8 +123,17 @@ struct file_body
         std::size_t put(const_buffers_type const& buffers, boost::system::error_code& ec);
         void finish(boost::system::error_code& ec);
 
+    private:
+        void write(const void* data, std::size_t n, boost::system::error_code& ec);
+        // direct writes go out in whole blocks from an aligned buffer.
+        void flush_staged(boost::system::error_code& ec);
+
     private:
         value_type& body_;
+        beast::file file_;
+        bool direct_ = false;
+        std::unique_ptr<char, void (*)(void*)> staging_ {nullptr, &std::free};
+        std::size_t staged_ = 0;
     };
 };
 } // namespace httplib::body
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 #include "httplib/config.hpp"
+#include "httplib/body/file_body.hpp"
 #include "httplib/html/form_data.hpp"
-#include <boost/algorithm/string/trim.hpp>
+#include "httplib/html/multipart_parser.hpp"
+#include <boost/beast/core/file.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
 #include <boost/beast/http/fields.hpp>
+#include <memory>
+#include <optional>
 
 namespace httplib::body {
 
@@ -27,6 +31,9 @@ public:
         value_type& body_;
         int field_data_index_ = 0;
         beast::flat_buffer buffer_;
+        // a part received to disk is sent from its file.
+        beast::file file_;
+        std::uint64_t file_remaining_ = 0;
 
         enum class step
         {
@@ -54,20 +61,19 @@ public:
 
         void finish(boost::system::error_code& ec);
 
+    private:
+        // moves the file part read so far to disk, the rest of it follows there.
+        void spill(boost::system::error_code& ec);
+
     private:
         value_type& body_;
         std::string content_type_;
-        std::string boundary_;
-        enum class step
-        {
-            boundary_line,
-            boundary_header,
-            boundary_content,
-            finshed,
-            eof
-        };
-        step step_ = step::boundary_line;
+        std::optional<html::multipart_parser> parser_;
         html::form_data::field field_data_;
+        std::unique_ptr<file_body::value_type> spill_body_;
+        std::optional<file_body::reader> spill_;
+        // what the parts spilled before the current one took, counted against spill_limit.
+        std::uint64_t spilled_ = 0;
     };
 };
 } // namespace httplib::body
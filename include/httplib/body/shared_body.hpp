@@ -0,0 +1,43 @@
+#pragma once
+#include "httplib/config.hpp"
+#include <boost/beast/http/error.hpp>
+#include <boost/beast/http/message.hpp>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace httplib::body {
+// An immutable buffer shared by every response sending it, e.g. a cached compressed body.
+// Only ever written, requests are not parsed into it.
+struct shared_body
+{
+    struct value_type
+    {
+        std::shared_ptr<const std::string> data;
+        // the bytes are in the Content-Encoding of the response already.
+        bool encoded = false;
+
+        std::size_t size() const { return data ? data->size() : 0; }
+    };
+    struct reader
+    {
+        explicit reader(const http::fields&, value_type&);
+
+        void init(boost::optional<std::uint64_t> const&, beast::error_code& ec);
+
+        std::size_t put(net::const_buffer const&, beast::error_code& ec);
+        void finish(beast::error_code& ec);
+    };
+    struct writer
+    {
+        using const_buffers_type = net::const_buffer;
+        explicit writer(const http::fields&, value_type const& b);
+        void init(beast::error_code& ec);
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec);
+
+    private:
+        value_type const& body_;
+    };
+};
+} // namespace httplib::body
@@ -1,6 +1,7 @@
 #pragma once
 #include <map>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace httplib::html {
@@ -30,6 +31,8 @@ class accept_encoding_content : public basic_accept_content
 {
 public:
     std::string server_apply_encoding() const;
+    // q=0 refuses an encoding, `*` stands for every encoding not listed.
+    bool accepts(std::string_view encoding) const;
 };
 
 } // namespace httplib::html
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
+#include "httplib/body/file_body.hpp"
 #include <algorithm>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <string>
 #include <string_view>
@@ -20,8 +23,10 @@ public:
         std::string filename;
         std::string content_type;
         std::string content;
+        // set instead of `content` for a file part received to disk, see spill_size.
+        std::shared_ptr<body::file_body::upload_file> file;
 
-        bool has_data() const { return !content.empty(); }
+        bool has_data() const { return !content.empty() || file; }
         bool is_file() const { return !filename.empty(); }
     };
 
@@ -32,6 +37,18 @@ public:
 
     std::string boundary;
 
+    /**
+     * File parts larger than spill_size are received to a temporary file in spill_directory
+     * (the system temp directory if empty) and reach the handler as field::file. 0 keeps every
+     * part in memory.
+     */
+    std::size_t spill_size = 0;
+    fs::path spill_directory;
+    // the bytes all spilled parts of one body may take together, a larger one fails the
+    // request. direct_io writes them with O_DIRECT, like body_mode::file uploads.
+    std::uint64_t spill_limit = (std::numeric_limits<std::uint64_t>::max)();
+    bool spill_direct_io      = false;
+
     /**
      * Get a field by name.
      *
@@ -59,7 +76,7 @@ public:
      * The the parsed data content of a specific field.
      *
      * @param field_name The name of the field.
-     * @return
+     * @return The content, empty for a part received to disk (field::file).
      */
     std::optional<std::string> content(std::string_view field_name) const;
 
@@ -0,0 +1,70 @@
+#pragma once
+#include "httplib/html/form_data.hpp"
+#include <array>
+#include <boost/system/error_code.hpp>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace httplib::html {
+
+// Incremental multipart/form-data parser. The body can be fed in pieces of any size and is
+// always consumed whole: part content is handed to on_part_data as soon as it is known not to
+// be a delimiter, only a possible partial delimiter or an incomplete part header is kept back.
+// Delimiters are searched with Boyer-Moore-Horspool over the whole piece.
+//
+// form_data_body reads buffered forms with it; a body_mode::streamed handler can feed it from
+// request::async_read_some to process uploads without holding them.
+class multipart_parser
+{
+public:
+    // the part's name, filename and content_type, content is left empty.
+    using part_begin_handler =
+        std::function<void(form_data::field& part, boost::system::error_code& ec)>;
+    using part_data_handler =
+        std::function<void(std::string_view data, boost::system::error_code& ec)>;
+    using part_end_handler = std::function<void(boost::system::error_code& ec)>;
+
+    part_begin_handler on_part_begin;
+    part_data_handler on_part_data;
+    part_end_handler on_part_end;
+
+public:
+    explicit multipart_parser(std::string_view boundary);
+    multipart_parser(const multipart_parser&)            = delete;
+    multipart_parser& operator=(const multipart_parser&) = delete;
+
+    // the boundary parameter of a multipart Content-Type, empty if there is none.
+    static std::string boundary_from_content_type(std::string_view content_type);
+
+    // fails with beast's unexpected_body on malformed input; after the closing delimiter the
+    // rest (the epilogue) is ignored.
+    void put(std::string_view data, boost::system::error_code& ec);
+    bool is_done() const { return step_ == step::epilogue; }
+
+private:
+    std::size_t parse(std::string_view data, boost::system::error_code& ec);
+    std::size_t parse_header(std::string_view data, boost::system::error_code& ec);
+    std::size_t find_delimiter(std::string_view data, std::size_t pos) const;
+    // bytes at the end of `data` that may start a delimiter.
+    std::size_t partial_delimiter(std::string_view data) const;
+
+private:
+    // "\r\n--boundary"; the body is parsed as if it started with "\r\n", so the first delimiter
+    // is no different from the others.
+    std::string delimiter_;
+    std::array<std::size_t, 256> skip_;
+    std::string pending_;
+
+    enum class step
+    {
+        preamble,
+        delimiter_end,
+        header,
+        content,
+        epilogue
+    };
+    step step_ = step::preamble;
+};
+
+} // namespace httplib::html
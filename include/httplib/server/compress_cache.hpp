@@ -0,0 +1,41 @@
+#pragma once
+#include "httplib/config.hpp"
+#include "httplib/server/compression_policy.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace httplib::server {
+
+class request;
+class response;
+
+// Aspect caching compressed response bodies:
+//
+//   compress_cache cache(32 * 1024 * 1024);
+//   router.set_http_handler<http::verb::get>("/app.js", handler, cache);
+//
+// The body is compressed once per (target, ETag, encoding), or per (body, encoding) when the
+// handler sets no ETag, and repeat responses reuse the compressed bytes: no compression, and a
+// Content-Length instead of chunked. Without an ETag the uncompressed body is kept with the
+// entry and compared on every hit. Which responses qualify is up to `policy`, or to the
+// route's compression_override. Copies share one cache, least recently used entries leave when
+// the byte budget is exceeded.
+class compress_cache
+{
+public:
+    explicit compress_cache(std::size_t max_bytes = 64 * 1024 * 1024,
+                            compression_policy policy = {});
+
+    bool after(request& req, response& resp);
+
+    std::uint64_t hits() const;
+    std::uint64_t misses() const;
+    std::size_t memory_used() const;
+
+private:
+    class impl;
+    std::shared_ptr<impl> impl_;
+    std::shared_ptr<const compression_policy> policy_;
+};
+
+} // namespace httplib::server
@@ -0,0 +1,47 @@
+#pragma once
+#include "httplib/config.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace httplib::server {
+
+class request;
+class response;
+
+// Which responses the server compresses on the fly (Accept-Encoding negotiation). Types are
+// matched without parameters, either exactly or as "type/*"; the deny list wins, an empty
+// allow list means the text-like types of mime_types.hpp.
+struct compression_policy
+{
+    bool enabled = true;
+    // bodies with a known size below this are sent as they are.
+    std::size_t min_size = 1024;
+    // bodies with a known size up to this are compressed before the header is written and keep
+    // a Content-Length, larger ones and unknown sizes are compressed while sent, chunked.
+    std::size_t max_buffered_size = 256 * 1024;
+    std::vector<std::string> allow_types;
+    std::vector<std::string> deny_types;
+
+    bool should_compress(std::string_view content_type, std::optional<std::uint64_t> size) const;
+};
+
+// Aspect giving a route its own policy instead of the server's one:
+//
+//   compression_policy policy;
+//   policy.enabled = false;
+//   router.set_http_handler<http::verb::get>("/download", handler, compression_override(policy));
+class compression_override
+{
+public:
+    explicit compression_override(compression_policy policy);
+
+    bool after(request& req, response& resp);
+
+private:
+    std::shared_ptr<const compression_policy> policy_;
+};
+
+} // namespace httplib::server
@@ -1,12 +1,16 @@
 #pragma once
+#include "httplib/body/file_body.hpp"
 #include "httplib/config.hpp"
 #include "httplib/server/helper.hpp"
 #include <boost/asio/awaitable.hpp>
+#include <chrono>
 #include <filesystem>
+#include <memory>
 
 namespace httplib::server {
 class request;
 class response;
+class file_cache;
 
 class mount_point_entry
 {
@@ -27,17 +31,42 @@ public:
     void set_enabled_dir(bool enabled);
     void set_dir_format(dir_format_type type);
     void set_default_doc_name(const std::vector<std::string>& default_doc_name);
+    // keeps up to `max_files` files open with their size, etag and mime type; an entry older
+    // than `ttl` is checked against the disk again. 0 disables the cache.
+    void set_file_cache(std::size_t max_files,
+                        const std::chrono::steady_clock::duration& ttl = std::chrono::seconds(1));
+    // files up to `max_file_size` are held in memory, `max_bytes` in total, least recently used
+    // out. Responses reference the cached bytes without copying them. Off by default, needs
+    // the file cache.
+    void set_memory_cache(std::size_t max_bytes, std::size_t max_file_size = 64 * 1024);
+    // serve "file.br", "file.zst" or "file.gz" stored next to "file" when the client accepts
+    // that encoding. Enabled by default.
+    void set_precompressed(bool enabled);
 
 public:
     void operator()(request& req, response& res) const;
 
+private:
+    void reset_file_cache();
+    void send_file(const fs::path& path,
+                   std::shared_ptr<const body::file_body::file_info> info,
+                   request& req,
+                   response& res) const;
+
 private:
     std::string mount_point_;
     fs::path base_dir_;
     bool enabled_dir_         = true;
     dir_format_type dir_type_ = dir_format_type::json;
+    bool precompressed_       = true;
 
     std::vector<std::string> default_doc_name_ = {"index.html", "index.htm"};
+
+    std::size_t file_cache_size_                        = 1024;
+    std::chrono::steady_clock::duration file_cache_ttl_ = std::chrono::seconds(1);
+    std::size_t memory_cache_size_                      = 0;
+    std::size_t memory_cache_file_size_                 = 0;
+    std::shared_ptr<file_cache> file_cache_;
 };
 
 } // namespace httplib::server
\ No newline at end of file
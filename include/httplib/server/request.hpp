@@ -1,14 +1,48 @@
 #pragma once
 #include "httplib/body/any_body.hpp"
+#include "httplib/server/static_routes.hpp"
 #include <any>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/http/empty_body.hpp>
 #include <boost/beast/http/message.hpp>
 
 namespace httplib::server {
 
+struct route_entry;
+
 class request : public http::request<body::any_body>
 {
+public:
+    // where a streamed body comes from, set by the connection.
+    class body_stream
+    {
+    public:
+        virtual ~body_stream() = default;
+
+        virtual net::awaitable<std::size_t> async_read_some(net::mutable_buffer buffer,
+                                                            boost::system::error_code& ec) = 0;
+        virtual bool is_done() const                                                        = 0;
+    };
+
+    // the route of the request, matched once as soon as the header is in and kept until the
+    // response is done.
+    struct route_match
+    {
+        // the router's entry for the method, null when no route takes it. Shared with the router,
+        // the handler stays alive while the request runs even if its route is removed.
+        std::shared_ptr<const route_entry> entry;
+        // set instead of entry for a route of the static table.
+        static_route_table::handler_type static_handler = nullptr;
+        std::vector<std::pair<std::string, std::string>> params;
+        // what the path does take, for the Allow header of a 405. Empty for an unknown path.
+        std::string allow;
+    };
+
 public:
     request(const tcp::endpoint& local_endpoint,
             const tcp::endpoint& remote_endpoint,
@@ -42,16 +76,32 @@ public:
     void add_path_param(const std::string& key, const std::string& val);
     void set_path_param(std::unordered_map<std::string, std::string>&& params);
 
+    // Routes set with body_mode::streamed read the body here instead of body(): the next bytes
+    // as sent (chunked framing removed, Content-Encoding kept), 0 once all of it was read.
+    net::awaitable<std::size_t> async_read_some(net::mutable_buffer buffer,
+                                                boost::system::error_code& ec);
+    bool is_body_done() const;
+    void set_body_stream(std::unique_ptr<body_stream>&& stream);
+
+    // null until the router matched the request.
+    const route_match* route() const;
+    // takes the params of the match as the path params.
+    void set_route(route_match&& match);
 
 private:
+    // only set when the path has percent escapes, path() is a view of the target otherwise.
     std::string decoded_path_;
-    html::query_params query_params_;
+    // decoded on first use.
+    mutable std::optional<html::query_params> query_params_;
 
     tcp::endpoint local_endpoint_;
     tcp::endpoint remote_endpoint_;
 
-    std::unordered_map<std::string, std::string> path_params_;
+    // a route has a handful of params at most, a flat vector beats hashing them.
+    std::vector<std::pair<std::string, std::string>> path_params_;
     std::any custom_data_;
+    std::unique_ptr<body_stream> body_stream_;
+    std::optional<route_match> route_;
 };
 
 
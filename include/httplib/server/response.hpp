@@ -1,6 +1,7 @@
 #pragma once
 #include "httplib/body/any_body.hpp"
 #include "httplib/config.hpp"
+#include "httplib/server/compression_policy.hpp"
 #include "httplib/html/form_data.hpp"
 #include "httplib/server/helper.hpp"
 #include "httplib/util/misc.hpp"
@@ -39,6 +40,9 @@ public:
     }
     void set_json_content(boost::json::value&& data, http::status status = http::status::ok);
     void set_file_content(const fs::path& path, const http::fields& req_header = {});
+    // an already open file, e.g. from a cache; `info` is shared, not copied. A 404 when null.
+    void set_file_content(std::shared_ptr<const body::file_body::file_info> info,
+                          const http::fields& req_header = {});
     void set_form_data_content(std::vector<html::form_data::field>&& data);
 
     void set_redirect(std::string_view url, http::status status = http::status::moved_permanently);
@@ -52,6 +56,17 @@ public:
         set_stream_content_impl(std::move(handler), content_type, status);
     }
 
+    // replaces the server's compression policy for this response, see compression_override.
+    void set_compression_policy(std::shared_ptr<const compression_policy> policy)
+    {
+        compression_policy_ = std::move(policy);
+    }
+    // null unless set_compression_policy was called.
+    const std::shared_ptr<const compression_policy>& get_compression_policy() const
+    {
+        return compression_policy_;
+    }
+
 private:
     using coro_stream_handler_type =
         std::function<net::awaitable<bool>(beast::flat_buffer& buffer, beast::error_code& ec)>;
@@ -62,8 +77,10 @@ private:
     void reset_content();
 
     coro_stream_handler_type stream_handler_;
+    std::shared_ptr<const compression_policy> compression_policy_;
 
     friend class session;
+    friend class http2_connection;
 };
 
 } // namespace httplib::server
\ No newline at end of file
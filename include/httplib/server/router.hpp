@@ -1,11 +1,14 @@
 #pragma once
 #include "httplib/server/mount_point_entry.hpp"
+#include "httplib/server/static_routes.hpp"
 #include "httplib/server/websocket_conn.hpp"
 #include <algorithm>
 #include <boost/asio/detached.hpp>
 #include <boost/beast/http/fields.hpp>
 #include <filesystem>
+#include <functional>
 #include <list>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -14,12 +17,40 @@ namespace httplib::server {
 class request;
 class response;
 
+// buffered: the body is read and parsed into body() before the handler runs.
+// streamed: the handler runs as soon as the header is in and pulls the body itself with
+// request::async_read_some, so an upload never has to fit in memory.
+// file: the body is written to a temporary file before the handler runs, body() holds a
+// file_body whose `upload` names it (see http_server::set_upload_directory).
+enum class body_mode
+{
+    buffered,
+    streamed,
+    file,
+};
+
 class router
 {
 public:
     virtual ~router() = default;
 
 public:
+    template<typename Func, typename... Aspects>
+    void set_http_handler(body_mode mode,
+                          http::verb method,
+                          std::string_view key,
+                          Func&& handler,
+                          Aspects&&... asps);
+
+    template<http::verb... method, typename Func, typename... Aspects>
+    void set_http_handler(body_mode mode, std::string_view key, Func&& handler, Aspects&&... asps)
+    {
+        static_assert(sizeof...(method) >= 1, "must set method");
+        (set_http_handler(
+             mode, method, key, std::forward<Func>(handler), std::forward<Aspects>(asps)...),
+         ...);
+    }
+
     template<typename Func, typename... Aspects>
     void
     set_http_handler(http::verb method, std::string_view key, Func&& handler, Aspects&&... asps);
@@ -58,6 +89,42 @@ public:
     template<typename Func>
     void set_http_post_handler(Func&& handler);
 
+    // A compile-time table (static_routes<...>) looked up before the routes above, which stay
+    // the fallback for every path it does not have. Must be called before run.
+    template<typename Table>
+        requires std::derived_from<Table, static_route_table>
+    void set_static_routes()
+    {
+        set_static_routes_impl(std::make_unique<Table>());
+    }
+
+    // Routes, websocket handlers and mounts can be removed, and set, while the server runs:
+    // every change publishes a new copy of the table without stopping requests, those already
+    // matched finish on the routes they were matched against. update() makes several changes
+    // one publication.
+    void remove_http_handler(http::verb method, std::string_view key)
+    {
+        remove_http_handler_impl(method, key);
+    }
+    template<http::verb... method>
+    void remove_http_handler(std::string_view key)
+    {
+        static_assert(sizeof...(method) >= 1, "must set method");
+        (remove_http_handler_impl(method, key), ...);
+    }
+    void remove_ws_handler(std::string_view key) { remove_ws_handler_impl(key); }
+    void remove_static_mount_point(const std::string& mount_point);
+
+    template<typename Func>
+    void update(Func&& func)
+    {
+        update_impl([&]() { func(*this); });
+    }
+
+    // Compiles the routes into the flat table requests are matched against and publishes it.
+    // The server does it when it starts, from then on every change publishes.
+    virtual void freeze() = 0;
+
 protected:
     using coro_http_handler_type =
         std::function<net::awaitable<void>(request& req, response& resp)>;
@@ -69,13 +136,19 @@ protected:
 
     virtual void set_http_handler_impl(http::verb method,
                                        std::string_view key,
-                                       coro_http_handler_type&& handler)                      = 0;
+                                       coro_http_handler_type&& handler,
+                                       body_mode mode,
+                                       bool may_suspend)                                      = 0;
     virtual void set_not_found_handler_impl(coro_http_handler_type&& handler)                 = 0;
     virtual void set_ws_handler_impl(std::string_view key,
                                      websocket_conn::coro_open_handler_type&& open_handler,
                                      websocket_conn::coro_message_handler_type&& message_handler,
                                      websocket_conn::coro_close_handler_type&& close_handler) = 0;
     virtual void set_http_post_handler_impl(coro_http_handler_type&& handler)                 = 0;
+    virtual void set_static_routes_impl(std::unique_ptr<static_route_table>&& table)          = 0;
+    virtual void remove_http_handler_impl(http::verb method, std::string_view key)            = 0;
+    virtual void remove_ws_handler_impl(std::string_view key)                                 = 0;
+    virtual void update_impl(const std::function<void()>& changes)                            = 0;
 };
 
 } // namespace httplib::server
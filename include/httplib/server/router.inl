@@ -48,10 +48,30 @@ void router::set_http_handler(http::verb method,
                               Func&& handler,
                               Aspects&&... asps)
 {
+    set_http_handler(body_mode::buffered,
+                     method,
+                     key,
+                     std::forward<Func>(handler),
+                     std::forward<Aspects>(asps)...);
+}
+
+template<typename Func, typename... Aspects>
+void router::set_http_handler(body_mode mode,
+                              http::verb method,
+                              std::string_view key,
+                              Func&& handler,
+                              Aspects&&... asps)
+{
+    using return_type = typename util::function_traits<std::decay_t<Func>>::return_type;
+    // aspects may be coroutines themselves.
+    constexpr bool may_suspend = util::is_awaitable_v<return_type> || sizeof...(Aspects) > 0;
+
     set_http_handler_impl(
         method,
         key,
-        make_coro_http_handler(std::forward<Func>(handler), std::forward<Aspects>(asps)...));
+        make_coro_http_handler(std::forward<Func>(handler), std::forward<Aspects>(asps)...),
+        mode,
+        may_suspend);
 }
 
 template<http::verb... method, typename Func, typename... Aspects>
@@ -112,6 +132,15 @@ void router::set_static_mount_point(mount_point_entry&& entry, Aspects&&... asps
         },
         std::forward<Aspects>(asps)...);
 }
+inline void router::remove_static_mount_point(const std::string& mount_point)
+{
+    std::string key = mount_point;
+    if (!key.ends_with("/"))
+        key += "/";
+    key += "*";
+
+    update([&](router& r) { r.remove_http_handler<http::verb::get, http::verb::head>(key); });
+}
 template<typename Func>
 void router::set_http_post_handler(Func&& handler)
 {
@@ -1,17 +1,25 @@
 #pragma once
 #include "httplib/config.hpp"
+#include "httplib/server/compression_policy.hpp"
 #include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/socket_base.hpp>
 #include <filesystem>
 #include <span>
+#include <thread>
 
 namespace httplib::server {
 
 class router;
 class session;
 
+enum class access_log_format
+{
+    common,
+    json
+};
+
 
 class http_server
 {
@@ -29,23 +37,94 @@ public:
                         uint16_t port,
                         int backlog = net::socket_base::max_listen_connections);
     http_server& listen(uint16_t port, int backlog = net::socket_base::max_listen_connections);
+    // SO_REUSEPORT sharded mode: listen() opens one acceptor per shard, each served by its own
+    // io_context on a dedicated cpu-pinned thread. Must be called before listen().
+    http_server& set_reuse_port_shards(std::size_t count = std::thread::hardware_concurrency());
+    std::size_t reuse_port_shards() const;
+
     net::awaitable<boost::system::error_code> co_run();
     void async_run();
     void stop();
 
+    // Graceful shutdown: stop accepting, close idle keep-alive connections, let in-flight
+    // requests finish with `Connection: close`. Completes once no request is in flight or the
+    // timeout expired; the remaining connections are aborted then. Returns false on timeout.
+    net::awaitable<bool> async_drain(const std::chrono::steady_clock::duration& timeout);
+    bool draining() const;
+    std::size_t in_flight_requests() const;
+
     httplib::server::router& router();
 
     tcp::endpoint local_endpoint() const;
 
+    std::size_t connection_count() const;
+
+    // read: between two reads of a request body, write: between two writes of a response,
+    // keep_alive: waiting for the next request on an idle connection, header: reading the
+    // request line and headers (tls handshake included). Checked at 100ms granularity.
     void set_read_timeout(const std::chrono::steady_clock::duration& dur);
     void set_write_timeout(const std::chrono::steady_clock::duration& dur);
+    void set_keep_alive_timeout(const std::chrono::steady_clock::duration& dur);
+    void set_header_timeout(const std::chrono::steady_clock::duration& dur);
 
     const std::chrono::steady_clock::duration& read_timeout() const;
     const std::chrono::steady_clock::duration& write_timeout() const;
+    const std::chrono::steady_clock::duration& keep_alive_timeout() const;
+    const std::chrono::steady_clock::duration& header_timeout() const;
+
+    // HTTP/2 (needs HTTPLIB_ENABLED_HTTP2): h2 over tls via ALPN, h2c by prior knowledge or
+    // Upgrade. Streams a client may open at once on one connection, 100 by default.
+    void set_http2_max_concurrent_streams(std::uint32_t count);
+    std::uint32_t http2_max_concurrent_streams() const;
+
+    // Encoder level per content-coding (needs HTTPLIB_ENABLED_COMPRESS), in the codec's own
+    // scale: gzip/deflate 1-9 (6), br 0-11 (6), zstd 1-22 (3). Process wide, the codecs are
+    // shared by every server and client: applies to everything encoded afterwards.
+    static void set_compression_level(std::string_view encoding, int level);
+    static int compression_level(std::string_view encoding);
+
+    // What is compressed on the fly, see compression_policy. Must be called before run.
+    void set_compression_policy(compression_policy policy);
+    const compression_policy& get_compression_policy() const;
+
+    // Request bodies of body_mode::file routes land in this directory, the system temp
+    // directory by default. direct_io writes them with O_DIRECT where the file system allows,
+    // keeping large uploads out of the page cache. Must be called before run.
+    void set_upload_directory(const fs::path& dir);
+    const fs::path& upload_directory() const;
+    void set_upload_direct_io(bool enabled);
+    bool upload_direct_io() const;
+    // Longest body a body_mode::file route receives, 1 GiB by default; a longer one fails the
+    // request and bounds the disk space reserved for it up front. Must be called before run.
+    void set_upload_limit(std::uint64_t bytes);
+    std::uint64_t upload_limit() const;
+    // File parts of multipart forms larger than this are received to the upload directory
+    // and reach the handler as form_data::field::file instead of content, within the upload
+    // limit for all parts of a form together and with direct_io as set. 0 (the default) keeps
+    // every part in memory. Must be called before run.
+    void set_form_data_spill_size(std::size_t bytes);
+    std::size_t form_data_spill_size() const;
+
+    // 0 means unlimited. When the global limit is reached the server stops accepting until a
+    // connection closes, or answers new ones with 503 when reject_on_overload is enabled.
+    void set_max_connections(std::size_t count);
+    void set_max_connections_per_ip(std::size_t count);
+    void set_reject_on_overload(bool enabled);
+
+    std::size_t max_connections() const;
+    std::size_t max_connections_per_ip() const;
+    bool reject_on_overload() const;
 
     std::shared_ptr<spdlog::logger> get_logger() const;
     void set_logger(std::shared_ptr<spdlog::logger> logger);
 
+    // Per-request access log, formatted and written by a background thread. Records that do not
+    // fit in its queue are dropped and counted instead of slowing requests down.
+    // Must be called before run.
+    void set_access_log(const fs::path& file,
+                        access_log_format format = access_log_format::common);
+    std::uint64_t access_log_dropped() const;
+
     void use_ssl(const std::span<const char>& cert_file,
                  const std::span<const char>& key_file,
                  std::string passwd = {});
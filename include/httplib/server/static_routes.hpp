@@ -0,0 +1,207 @@
+#pragma once
+#include "httplib/config.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <boost/asio/awaitable.hpp>
+#include <boost/beast/http/verb.hpp>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace httplib::server {
+
+class request;
+class response;
+
+// A route table the router looks up before the routes set at runtime, which stay the fallback
+// for every path it does not have.
+class static_route_table
+{
+public:
+    using handler_type = net::awaitable<void> (*)(request& req, response& resp);
+
+    virtual ~static_route_table() = default;
+
+    // the handler for `method` at exactly `path`, null if there is none. `allowed` gains a bit
+    // per http::verb the path does have.
+    virtual handler_type
+    find(http::verb method, std::string_view path, std::uint64_t& allowed) const = 0;
+};
+
+// a string literal as a template argument: static_route<"/api/health", ...>
+template<std::size_t N>
+struct fixed_string
+{
+    char value[N] {};
+
+    constexpr fixed_string(const char (&str)[N]) { std::copy_n(str, N, value); }
+    constexpr std::string_view view() const { return {value, N - 1}; }
+};
+
+// One route of a static_routes table: an exact path (no params), its methods and the handler,
+// a function or captureless lambda taking (request&, response&) that returns void or
+// net::awaitable<void>. It is called directly, without aspects.
+template<fixed_string Path, auto Handler, http::verb... Methods>
+struct static_route
+{
+    static_assert(sizeof...(Methods) >= 1, "must set method");
+
+    static constexpr std::string_view path = Path.view();
+    static constexpr std::uint64_t methods =
+        ((std::uint64_t(1) << static_cast<unsigned>(Methods)) | ...);
+
+    static net::awaitable<void> invoke(request& req, response& resp)
+    {
+        using result_type = std::invoke_result_t<decltype(Handler), request&, response&>;
+        if constexpr (std::is_same_v<result_type, net::awaitable<void>>)
+            return Handler(req, resp);
+        else
+            return invoke_sync(req, resp);
+    }
+
+private:
+    static net::awaitable<void> invoke_sync(request& req, response& resp)
+    {
+        Handler(req, resp);
+        co_return;
+    }
+};
+
+namespace detail {
+
+constexpr std::uint32_t static_route_hash(std::string_view str, std::uint32_t seed)
+{
+    // fnv-1a, seeded, with murmur3's finalizer so every seed spreads the keys anew.
+    std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : str) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// A perfect hash over the paths, built at compile time by hash and displace: a path picks a
+// bucket with seed 0, the bucket's seed picks its slot. The buckets are placed largest first,
+// each trying seeds until all its paths land in free slots.
+template<std::size_t N>
+struct static_route_index
+{
+    static constexpr std::size_t slot_count = std::bit_ceil(N * 2);
+
+    std::array<std::uint32_t, N> seeds {};
+    // route index + 1 of the first route with the path hashed there, 0 for a free slot.
+    std::array<std::uint16_t, slot_count> slots {};
+    // route index + 1 of the next route with the same path, 0 at the end.
+    std::array<std::uint16_t, N> next {};
+
+    consteval explicit static_route_index(const std::array<std::string_view, N>& paths)
+    {
+        std::array<std::size_t, N> bucket_size {};
+        std::array<bool, N> is_key {};
+        for (std::size_t i = 0; i < N; ++i) {
+            is_key[i] = true;
+            for (std::size_t j = 0; j < i; ++j) {
+                if (is_key[j] && paths[j] == paths[i]) {
+                    is_key[i] = false;
+                    auto last = j;
+                    while (next[last] != 0)
+                        last = next[last] - 1u;
+                    next[last] = static_cast<std::uint16_t>(i + 1);
+                    break;
+                }
+            }
+            if (is_key[i])
+                ++bucket_size[static_route_hash(paths[i], 0) % N];
+        }
+
+        std::array<std::size_t, N> order {};
+        for (std::size_t b = 0; b < N; ++b)
+            order[b] = b;
+        std::ranges::sort(order, [&](auto a, auto b) { return bucket_size[a] > bucket_size[b]; });
+
+        for (auto b : order) {
+            if (bucket_size[b] == 0)
+                break;
+            for (std::uint32_t seed = 1;; ++seed) {
+                if (try_place(paths, is_key, b, seed)) {
+                    seeds[b] = seed;
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr std::size_t lookup(std::string_view path) const
+    {
+        auto seed = seeds[static_route_hash(path, 0) % N];
+        return slots[static_route_hash(path, seed) & (slot_count - 1)];
+    }
+
+private:
+    consteval bool try_place(const std::array<std::string_view, N>& paths,
+                             const std::array<bool, N>& is_key,
+                             std::size_t bucket,
+                             std::uint32_t seed)
+    {
+        auto placed = slots;
+        for (std::size_t i = 0; i < N; ++i) {
+            if (!is_key[i] || static_route_hash(paths[i], 0) % N != bucket)
+                continue;
+            auto slot = static_route_hash(paths[i], seed) & (slot_count - 1);
+            if (placed[slot] != 0)
+                return false;
+            placed[slot] = static_cast<std::uint16_t>(i + 1);
+        }
+        slots = placed;
+        return true;
+    }
+};
+
+} // namespace detail
+
+// A route table fixed at compile time:
+//
+//   using api = static_routes<static_route<"/health", &health, http::verb::get>,
+//                             static_route<"/orders", &orders, http::verb::get, http::verb::post>>;
+//   server.router().set_static_routes<api>();
+//
+// A lookup hashes the path once into a table laid out by the compiler, compares one path and
+// calls the handler through a plain function pointer.
+template<typename... Routes>
+class static_routes final : public static_route_table
+{
+public:
+    static constexpr std::size_t size = sizeof...(Routes);
+    static_assert(size >= 1 && size < 65535, "a static route table holds 1 to 65534 routes");
+
+    handler_type
+    find(http::verb method, std::string_view path, std::uint64_t& allowed) const override
+    {
+        auto index = index_.lookup(path);
+        if (index == 0 || paths_[index - 1] != path)
+            return nullptr;
+
+        auto bit = std::uint64_t(1) << static_cast<unsigned>(method);
+        for (--index;; index = index_.next[index] - 1u) {
+            allowed |= methods_[index];
+            if (methods_[index] & bit)
+                return handlers_[index];
+            if (index_.next[index] == 0)
+                return nullptr;
+        }
+    }
+
+private:
+    static constexpr std::array<std::string_view, size> paths_ {Routes::path...};
+    static constexpr std::array<std::uint64_t, size> methods_ {Routes::methods...};
+    static constexpr std::array<handler_type, size> handlers_ {&Routes::invoke...};
+    static constexpr detail::static_route_index<size> index_ {paths_};
+};
+
+} // namespace httplib::server
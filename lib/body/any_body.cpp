@@ -1,5 +1,6 @@
 #include "httplib/body/any_body.hpp"
 #include "compressor.hpp"
+#include <boost/beast/core/string.hpp>
 
 namespace httplib::body {
 namespace detail {
@@ -73,6 +74,24 @@ private:
 };
 
 
+// precompressed files and cached compressed bodies are in their content encoding already.
+static bool is_encoded(const any_body::value_type& body)
+{
+    if (body.is_body_type<shared_body>())
+        return body.as<shared_body>().encoded;
+    if (!body.is_body_type<file_body>())
+        return false;
+    const auto& file = body.as<file_body>();
+    return file.info && !file.info->content_encoding.empty();
+}
+
+// media types are case-insensitive, parameters may follow.
+static bool is_media_type(std::string_view content_type, std::string_view type)
+{
+    return content_type.size() >= type.size() &&
+           beast::iequals(content_type.substr(0, type.size()), type);
+}
+
 } // namespace detail
 
 
@@ -88,8 +107,9 @@ public:
     {
         auto content_encoding = header_[http::field::content_encoding];
 
-        proxy_      = create_proxy_writer(header_, body_);
-        compressor_ = compressor_factory::instance().create(content_encoding);
+        proxy_ = create_proxy_writer(header_, body_);
+        if (!detail::is_encoded(body_))
+            compressor_ = compressor_factory::instance().create(content_encoding);
 
         if (compressor_)
             compressor_->init(compressor::mode::encode);
@@ -102,14 +122,20 @@ public:
             return proxy_->get(ec);
 
         compressor_->consume_all();
+        if (finished_)
+            return boost::none;
         for (;;) {
             auto result = proxy_->get(ec);
-            if (!result || ec)
+            if (ec)
                 return result;
 
+            // the body ended without a last chunk, flush what the encoder still holds.
             if (!result) {
+                finished_ = true;
                 compressor_->finish();
                 auto buffer = compressor_->buffer();
+                if (buffer.size() == 0)
+                    return boost::none;
                 return {{buffer, false}};
             }
 
@@ -144,6 +170,7 @@ private:
 
     detail::proxy_writer::ptr proxy_;
     compressor::ptr compressor_;
+    bool finished_ = false;
 };
 
 class any_body::reader::impl
@@ -159,13 +186,17 @@ public:
         auto content_type     = header_[http::field::content_type];
         auto content_encoding = header_[http::field::content_encoding];
 
-        if (content_type.starts_with("multipart/form-data")) {
+        // a route receiving to disk prepared the upload before the body started.
+        if (body_.is_body_type<file_body>() && body_.as<file_body>().upload) {
+            proxy_ = create_proxy_reader<file_body>(header_, body_);
+        }
+        else if (detail::is_media_type(content_type, "multipart/form-data")) {
             proxy_ = create_proxy_reader<form_data_body>(header_, body_);
         }
-        else if (content_type.starts_with("application/json")) {
+        else if (detail::is_media_type(content_type, "application/json")) {
             proxy_ = create_proxy_reader<json_body>(header_, body_);
         }
-        else if (content_type.starts_with("application/x-www-form-urlencoded")) {
+        else if (detail::is_media_type(content_type, "application/x-www-form-urlencoded")) {
             proxy_ = create_proxy_reader<query_params_body>(header_, body_);
         }
         else {
@@ -1,107 +1,369 @@
 #include "compressor.hpp"
 
 #ifdef HTTPLIB_ENABLED_COMPRESS
-#include "brotli.hpp"
-#include <boost/asio/streambuf.hpp>
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
-#include <boost/iostreams/filter/zstd.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#include <stdexcept>
+#include <zlib.h>
+#include <zstd.h>
 #endif
 
 namespace httplib::body {
 #ifdef HTTPLIB_ENABLED_COMPRESS
-namespace io = boost::iostreams;
+namespace detail {
 
-class basic_compressor : public compressor
+// Codec contexts are expensive to set up (deflate state alone is ~256KB), so finished ones go
+// back to a small per thread pool and are reset for the next message instead.
+template<typename Context>
+class context_pool
 {
 public:
-    explicit basic_compressor() { }
+    static constexpr std::size_t max_size = 8;
 
-    void init(mode m)
+    template<typename Match>
+    static std::unique_ptr<Context> acquire(Match&& match)
     {
-        init_filtering_ostreambuf(m, stream_);
-        stream_.push(buffer_);
+        auto& pool = instance();
+        for (auto iter = pool.rbegin(); iter != pool.rend(); ++iter) {
+            if (match(**iter)) {
+                auto ctx = std::move(*iter);
+                pool.erase(std::next(iter).base());
+                return ctx;
+            }
+        }
+        return nullptr;
+    }
+    static void release(std::unique_ptr<Context> ctx)
+    {
+        auto& pool = instance();
+        if (ctx && pool.size() < max_size)
+            pool.push_back(std::move(ctx));
     }
 
-    net::const_buffer buffer() const { return buffer_.data(); }
-    void write(const net::const_buffer& buffer, bool more = true)
+private:
+    static std::vector<std::unique_ptr<Context>>& instance()
     {
-        io::write(stream_, (const char*)buffer.data(), buffer.size());
-        if (!more) {
-            io::close(stream_);
-        }
+        thread_local std::vector<std::unique_ptr<Context>> pool;
+        return pool;
     }
-    void finish() { io::close(stream_); }
-    void consume_all() { buffer_.consume(buffer_.size()); }
-    void consume(std::size_t bytes) { buffer_.consume(bytes); }
+};
 
-protected:
-    virtual void init_filtering_ostreambuf(mode m, io::filtering_ostreambuf& stream) = 0;
+struct deflate_context
+{
+    deflate_context(int level, int window_bits)
+        : level(level)
+        , window_bits(window_bits)
+    {
+        if (deflateInit2(&stream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("Failed to create zlib encoder");
+    }
+    ~deflate_context() { deflateEnd(&stream); }
 
-private:
-    net::streambuf buffer_;
-    io::filtering_ostreambuf stream_;
+    z_stream stream {};
+    int level;
+    int window_bits;
 };
 
-class gzip_compressor_adapter : public basic_compressor
+struct inflate_context
 {
-protected:
-    void init_filtering_ostreambuf(mode m, io::filtering_ostreambuf& stream) override
+    inflate_context()
     {
-        switch (m) {
-            case mode::encode: stream.push(io::gzip_compressor()); break;
-            case mode::decode: stream.push(io::gzip_decompressor()); break;
-            default: break;
-        }
+        // 32: detect a zlib or a gzip header.
+        if (inflateInit2(&stream, 15 + 32) != Z_OK)
+            throw std::runtime_error("Failed to create zlib decoder");
+    }
+    ~inflate_context() { inflateEnd(&stream); }
+
+    z_stream stream {};
+};
+
+struct zstd_cctx
+{
+    zstd_cctx()
+        : ctx(ZSTD_createCCtx())
+    {
+        if (!ctx)
+            throw std::runtime_error("Failed to create zstd encoder");
     }
+    ~zstd_cctx() { ZSTD_freeCCtx(ctx); }
+
+    ZSTD_CCtx* ctx;
 };
-class zlib_compressor_adapter : public basic_compressor
+
+struct zstd_dctx
 {
+    zstd_dctx()
+        : ctx(ZSTD_createDCtx())
+    {
+        if (!ctx)
+            throw std::runtime_error("Failed to create zstd decoder");
+    }
+    ~zstd_dctx() { ZSTD_freeDCtx(ctx); }
+
+    ZSTD_DCtx* ctx;
+};
+
+} // namespace detail
+
+// The codecs write straight into the output buffer, no stream layer in between.
+class stream_compressor : public compressor
+{
+public:
+    net::const_buffer buffer() const override { return buffer_.data(); }
+    void write(const net::const_buffer& buffer, bool more = true) override
+    {
+        process(static_cast<const std::uint8_t*>(buffer.data()), buffer.size(), !more);
+    }
+    void finish() override { process(nullptr, 0, true); }
+    void consume_all() override { buffer_.consume(buffer_.size()); }
+    void consume(std::size_t bytes) override { buffer_.consume(bytes); }
+
 protected:
-    void init_filtering_ostreambuf(mode m, io::filtering_ostreambuf& stream) override
+    // consumes input and fills output, true once the end of the stream was written or read.
+    virtual bool run(const std::uint8_t*& in,
+                     std::size_t& in_size,
+                     std::uint8_t*& out,
+                     std::size_t& out_size,
+                     bool finish) = 0;
+
+private:
+    void process(const std::uint8_t* in, std::size_t in_size, bool finish)
     {
-        switch (m) {
-            case mode::encode: stream.push(io::zlib_compressor()); break;
-            case mode::decode: stream.push(io::zlib_decompressor()); break;
-            default: break;
+        static constexpr std::size_t min_output_size = 16 * 1024;
+
+        if (done_)
+            return;
+        for (;;) {
+            auto output   = buffer_.prepare((std::max)(min_output_size, in_size));
+            auto* out     = static_cast<std::uint8_t*>(output.data());
+            auto out_size = output.size();
+
+            done_ = run(in, in_size, out, out_size, finish);
+            buffer_.commit(output.size() - out_size);
+
+            // input used up and output space left over: nothing more to do for now.
+            if (done_ || (in_size == 0 && out_size != 0))
+                return;
         }
     }
+
+    beast::flat_buffer buffer_;
+    bool done_ = false;
 };
-class zstd_compressor_adapter : public basic_compressor
+
+class zlib_compressor : public stream_compressor
 {
+public:
+    zlib_compressor(int window_bits, int level)
+        : window_bits_(window_bits)
+        , level_(level)
+    {
+    }
+    ~zlib_compressor()
+    {
+        detail::context_pool<detail::deflate_context>::release(std::move(deflate_));
+        detail::context_pool<detail::inflate_context>::release(std::move(inflate_));
+    }
+
+    void init(mode m) override
+    {
+        if (m == mode::encode) {
+            deflate_ = detail::context_pool<detail::deflate_context>::acquire([&](auto& ctx) {
+                return ctx.level == level_ && ctx.window_bits == window_bits_;
+            });
+            if (deflate_)
+                deflateReset(&deflate_->stream);
+            else
+                deflate_ = std::make_unique<detail::deflate_context>(level_, window_bits_);
+        }
+        else {
+            inflate_ = detail::context_pool<detail::inflate_context>::acquire([](auto&) {
+                return true;
+            });
+            if (inflate_)
+                inflateReset(&inflate_->stream);
+            else
+                inflate_ = std::make_unique<detail::inflate_context>();
+        }
+    }
+
 protected:
-    void init_filtering_ostreambuf(mode m, io::filtering_ostreambuf& stream) override
+    bool run(const std::uint8_t*& in,
+             std::size_t& in_size,
+             std::uint8_t*& out,
+             std::size_t& out_size,
+             bool finish) override
+    {
+        auto& stream     = deflate_ ? deflate_->stream : inflate_->stream;
+        stream.next_in   = const_cast<Bytef*>(in);
+        stream.avail_in  = static_cast<uInt>(in_size);
+        stream.next_out  = out;
+        stream.avail_out = static_cast<uInt>(out_size);
+
+        int result = deflate_ ? ::deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH)
+                              : ::inflate(&stream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+            throw std::runtime_error(deflate_ ? "zlib compression failed"
+                                              : "zlib decompression failed");
+
+        in       = stream.next_in;
+        in_size  = stream.avail_in;
+        out      = stream.next_out;
+        out_size = stream.avail_out;
+        return result == Z_STREAM_END;
+    }
+
+private:
+    int window_bits_;
+    int level_;
+    std::unique_ptr<detail::deflate_context> deflate_;
+    std::unique_ptr<detail::inflate_context> inflate_;
+};
+
+class zstd_compressor : public stream_compressor
+{
+public:
+    explicit zstd_compressor(int level)
+        : level_(level)
     {
-        switch (m) {
-            case mode::encode: stream.push(io::zstd_compressor()); break;
-            case mode::decode: stream.push(io::zstd_decompressor()); break;
-            default: break;
+    }
+    ~zstd_compressor()
+    {
+        detail::context_pool<detail::zstd_cctx>::release(std::move(cctx_));
+        detail::context_pool<detail::zstd_dctx>::release(std::move(dctx_));
+    }
+
+    void init(mode m) override
+    {
+        if (m == mode::encode) {
+            cctx_ = detail::context_pool<detail::zstd_cctx>::acquire([](auto&) { return true; });
+            if (!cctx_)
+                cctx_ = std::make_unique<detail::zstd_cctx>();
+            ZSTD_CCtx_reset(cctx_->ctx, ZSTD_reset_session_and_parameters);
+            ZSTD_CCtx_setParameter(cctx_->ctx, ZSTD_c_compressionLevel, level_);
+        }
+        else {
+            dctx_ = detail::context_pool<detail::zstd_dctx>::acquire([](auto&) { return true; });
+            if (!dctx_)
+                dctx_ = std::make_unique<detail::zstd_dctx>();
+            ZSTD_DCtx_reset(dctx_->ctx, ZSTD_reset_session_only);
         }
     }
+
+protected:
+    bool run(const std::uint8_t*& in,
+             std::size_t& in_size,
+             std::uint8_t*& out,
+             std::size_t& out_size,
+             bool finish) override
+    {
+        ZSTD_inBuffer input {in, in_size, 0};
+        ZSTD_outBuffer output {out, out_size, 0};
+
+        std::size_t result = 0;
+        if (cctx_)
+            result = ZSTD_compressStream2(
+                cctx_->ctx, &output, &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+        else
+            result = ZSTD_decompressStream(dctx_->ctx, &output, &input);
+        if (ZSTD_isError(result))
+            throw std::runtime_error(ZSTD_getErrorName(result));
+
+        in += input.pos;
+        in_size -= input.pos;
+        out += output.pos;
+        out_size -= output.pos;
+        // both report 0 once a frame is complete. A body may be several frames one after
+        // another, the decoder goes on with the next one until the input ends.
+        return result == 0 && finish && (cctx_ || in_size == 0);
+    }
+
+private:
+    int level_;
+    std::unique_ptr<detail::zstd_cctx> cctx_;
+    std::unique_ptr<detail::zstd_dctx> dctx_;
 };
-class brotli_compressor_adapter : public basic_compressor
+
+class brotli_compressor : public stream_compressor
 {
+public:
+    explicit brotli_compressor(int quality)
+        : quality_(quality)
+        , encoder_(nullptr, &BrotliEncoderDestroyInstance)
+        , decoder_(nullptr, &BrotliDecoderDestroyInstance)
+    {
+    }
+
+    // brotli states can not be reset, every message gets its own.
+    void init(mode m) override
+    {
+        if (m == mode::encode) {
+            encoder_.reset(BrotliEncoderCreateInstance(nullptr, nullptr, nullptr));
+            if (!encoder_)
+                throw std::runtime_error("Failed to create Brotli encoder");
+            BrotliEncoderSetParameter(encoder_.get(), BROTLI_PARAM_QUALITY, quality_);
+        }
+        else {
+            decoder_.reset(BrotliDecoderCreateInstance(nullptr, nullptr, nullptr));
+            if (!decoder_)
+                throw std::runtime_error("Failed to create Brotli decoder");
+        }
+    }
+
 protected:
-    void init_filtering_ostreambuf(mode m, io::filtering_ostreambuf& stream) override
+    bool run(const std::uint8_t*& in,
+             std::size_t& in_size,
+             std::uint8_t*& out,
+             std::size_t& out_size,
+             bool finish) override
     {
-        switch (m) {
-            case mode::encode: stream.push(brotli_compressor()); break;
-            case mode::decode: stream.push(brotli_decompressor()); break;
-            default: break;
+        if (encoder_) {
+            if (!BrotliEncoderCompressStream(encoder_.get(),
+                                             finish ? BROTLI_OPERATION_FINISH
+                                                    : BROTLI_OPERATION_PROCESS,
+                                             &in_size,
+                                             &in,
+                                             &out_size,
+                                             &out,
+                                             nullptr))
+                throw std::runtime_error("Brotli compression failed");
+            return BrotliEncoderIsFinished(encoder_.get());
         }
+
+        auto result =
+            BrotliDecoderDecompressStream(decoder_.get(), &in_size, &in, &out_size, &out, nullptr);
+        if (result == BROTLI_DECODER_RESULT_ERROR)
+            throw std::runtime_error("Brotli decompression error");
+        return result == BROTLI_DECODER_RESULT_SUCCESS;
     }
+
+private:
+    int quality_;
+    std::unique_ptr<BrotliEncoderState, void (*)(BrotliEncoderState*)> encoder_;
+    std::unique_ptr<BrotliDecoderState, void (*)(BrotliDecoderState*)> decoder_;
 };
 
 #endif
 
 compressor_factory::compressor_factory()
 {
+    levels_[static_cast<std::size_t>(codec::gzip)]    = 6;
+    levels_[static_cast<std::size_t>(codec::deflate)] = 6;
+    levels_[static_cast<std::size_t>(codec::zstd)]    = 3;
+    levels_[static_cast<std::size_t>(codec::br)]      = 6;
 #ifdef HTTPLIB_ENABLED_COMPRESS
-    register_compressor("gzip", []() { return std::make_unique<gzip_compressor_adapter>(); });
-    register_compressor("deflate", []() { return std::make_unique<zlib_compressor_adapter>(); });
-    register_compressor("zstd", []() { return std::make_unique<zstd_compressor_adapter>(); });
-    register_compressor("br", []() { return std::make_unique<brotli_compressor_adapter>(); });
+    // window bits: 15 plus 16 for a gzip wrapper, "deflate" is the zlib format.
+    register_compressor("gzip", [this]() {
+        return std::make_unique<zlib_compressor>(15 + 16, level("gzip"));
+    });
+    register_compressor("deflate", [this]() {
+        return std::make_unique<zlib_compressor>(15, level("deflate"));
+    });
+    register_compressor("zstd", [this]() {
+        return std::make_unique<zstd_compressor>(level("zstd"));
+    });
+    register_compressor("br", [this]() { return std::make_unique<brotli_compressor>(level("br")); });
 #endif
 }
 compressor_factory& compressor_factory::instance()
@@ -140,4 +402,29 @@ bool compressor_factory::is_supported_encoding(std::string_view encoding) const
     return iter != creators_.end();
 }
 
-} // namespace httplib::body
\ No newline at end of file
+std::optional<compressor_factory::codec> compressor_factory::find_codec(std::string_view encoding)
+{
+    if (encoding == "gzip")
+        return codec::gzip;
+    if (encoding == "deflate")
+        return codec::deflate;
+    if (encoding == "zstd")
+        return codec::zstd;
+    if (encoding == "br")
+        return codec::br;
+    return std::nullopt;
+}
+
+void compressor_factory::set_level(std::string_view encoding, int level)
+{
+    if (auto c = find_codec(encoding); c)
+        levels_[static_cast<std::size_t>(*c)].store(level, std::memory_order_relaxed);
+}
+
+int compressor_factory::level(std::string_view encoding) const
+{
+    auto c = find_codec(encoding);
+    return c ? levels_[static_cast<std::size_t>(*c)].load(std::memory_order_relaxed) : 0;
+}
+
+} // namespace httplib::body
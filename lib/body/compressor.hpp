@@ -1,7 +1,11 @@
 #pragma once
 #include "httplib/config.hpp"
+#include <array>
+#include <atomic>
 #include <boost/asio/buffer.hpp>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <unordered_map>
 
 namespace httplib::body {
@@ -36,12 +40,28 @@ public:
 
     bool is_supported_encoding(std::string_view encoding) const;
 
+    // encoder level of one encoding, in the codec's own scale (zlib 1-9, brotli 0-11,
+    // zstd 1-22). Unknown encodings are ignored.
+    void set_level(std::string_view encoding, int level);
+    int level(std::string_view encoding) const;
+
 public:
     static compressor_factory& instance();
 
 private:
+    enum class codec
+    {
+        gzip,
+        deflate,
+        zstd,
+        br,
+        count
+    };
+    static std::optional<codec> find_codec(std::string_view encoding);
+
     compressor_factory();
     void register_compressor(const std::string& encoding, create_function&& func);
     std::unordered_map<std::string, create_function> creators_;
+    std::array<std::atomic_int, static_cast<std::size_t>(codec::count)> levels_;
 };
-} // namespace httplib::body
\ No newline at end of file
+} // namespace httplib::body
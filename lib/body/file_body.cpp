@@ -1,8 +1,132 @@
 #include "httplib/body/file_body.hpp"
+#include "html/html.h"
+#include "mime_types.hpp"
+#include <atomic>
+#include <cstring>
 #include <fmt/format.h>
+#include <random>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace httplib::body {
 
+namespace detail {
+
+static constexpr std::size_t direct_io_alignment = 4096;
+static constexpr std::size_t staging_size        = 1024 * 1024;
+
+static fs::path unique_upload_path(const fs::path& directory)
+{
+    static std::atomic_uint64_t counter = 0;
+    thread_local std::mt19937_64 rng(std::random_device {}());
+    return directory / fmt::format("httplib-upload-{:016x}-{}", rng(), counter.fetch_add(1));
+}
+
+} // namespace detail
+
+std::shared_ptr<file_body::file_info> file_body::file_info::open(
+    const fs::path& path,
+    boost::system::error_code& ec,
+    std::string_view content_encoding /*= {}*/)
+{
+    std::error_code std_ec;
+    if (!fs::is_regular_file(path, std_ec)) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::no_such_file_or_directory);
+        return nullptr;
+    }
+    auto last_write_time = html::file_last_write_time(path, std_ec);
+    if (std_ec) {
+        ec.assign(std_ec.value(), boost::system::system_category());
+        return nullptr;
+    }
+
+    auto info = std::make_shared<file_info>();
+    info->file.open(path.string().c_str(), beast::file_mode::scan, ec);
+    if (ec)
+        return nullptr;
+    info->size = info->file.size(ec);
+    if (ec)
+        return nullptr;
+
+    info->last_write_time = last_write_time;
+    info->last_modified   = html::format_http_gmt_date(last_write_time);
+    if (content_encoding.empty()) {
+        info->etag         = fmt::format("W/{}-{}", info->size, last_write_time);
+        info->content_type = mime::get_mime_type(path.extension().string());
+    }
+    else {
+        info->etag = fmt::format("W/{}-{}-{}", info->size, last_write_time, content_encoding);
+        info->content_type     = mime::get_mime_type(path.stem().extension().string());
+        info->content_encoding = content_encoding;
+    }
+    return info;
+}
+
+void file_body::file_info::load(boost::system::error_code& ec)
+{
+    std::string data(static_cast<std::size_t>(size), '\0');
+    std::size_t offset = 0;
+    while (offset < data.size()) {
+        auto bytes = read_at(offset, data.data() + offset, data.size() - offset, ec);
+        if (ec)
+            return;
+        if (bytes == 0) {
+            ec = http::error::short_read;
+            return;
+        }
+        offset += bytes;
+    }
+    content = std::move(data);
+    loaded  = true;
+}
+
+std::size_t file_body::file_info::read_at(std::uint64_t offset,
+                                          void* buffer,
+                                          std::size_t n,
+                                          boost::system::error_code& ec) const
+{
+#ifdef _WIN32
+    OVERLAPPED overlapped {};
+    overlapped.Offset     = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD bytes = 0;
+    if (!::ReadFile(file.native_handle(),
+                    buffer,
+                    static_cast<DWORD>((std::min)(n, std::size_t(0xffffffff))),
+                    &bytes,
+                    &overlapped)) {
+        auto err = ::GetLastError();
+        if (err == ERROR_HANDLE_EOF) {
+            ec = {};
+            return 0;
+        }
+        ec.assign(static_cast<int>(err), boost::system::system_category());
+        return 0;
+    }
+    ec = {};
+    return bytes;
+#else
+    for (;;) {
+        auto bytes = ::pread(file.native_handle(), buffer, n, static_cast<off_t>(offset));
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+            ec.assign(errno, boost::system::system_category());
+            return 0;
+        }
+        ec = {};
+        return static_cast<std::size_t>(bytes);
+    }
+#endif
+}
+
 file_body::writer::writer(const http::fields&, value_type& b)
     : body_(b)
 {
@@ -25,25 +149,13 @@ file_body::writer::get(boost::system::error_code& ec)
             range.second = range.second + 1;
         }
 
-        if (!pos_) {
+        if (!pos_)
             pos_ = range.first;
-            body_.seekg(*pos_);
-        }
-        std::size_t const n = (std::min)(sizeof(buf_), beast::detail::clamp(range.second - *pos_));
-        if (n == 0) {
-            ec = {};
-            return boost::none;
-        }
-        auto const nread = body_.read(buf_, n);
-        if (nread == 0) {
-            ec = http::error::short_read;
+        auto buffer = read_content(range.second, ec);
+        if (ec || buffer.size() == 0)
             return boost::none;
-        }
-        BOOST_ASSERT(nread != 0);
-        *pos_ += nread;
-        ec = {};
 
-        return {{{buf_, nread},          // buffer to return.
+        return {{buffer,                 // buffer to return.
                  *pos_ < range.second}}; // `true` if there are more buffers.
     }
 
@@ -62,7 +174,7 @@ file_body::writer::get(boost::system::error_code& ec)
             std::string header = fmt::format("--{}\r\n", body_.boundary);
             header += fmt::format("Content-Type: {}\r\n", body_.content_type);
             header += fmt::format(
-                "Content-Range: bytes {}-{}/{}\r\n", range.first, range.second, file_size_);
+                "Content-Range: bytes {}-{}/{}\r\n", range.first, range.second, body_.file_size());
             header += "\r\n";
             strcpy(buf_, header.c_str());
             step_ = step::content;
@@ -70,26 +182,16 @@ file_body::writer::get(boost::system::error_code& ec)
             return {{{buf_, header.size()}, true}};
         } break;
         case step::content: {
-            if (!pos_) {
+            if (!pos_)
                 pos_ = range.first;
-                body_.seekg(*pos_);
-            }
-            std::size_t const n =
-                (std::min)(sizeof(buf_), beast::detail::clamp(range.second - *pos_));
-            if (n == 0) {
+            auto buffer = read_content(range.second + 1, ec);
+            if (ec)
+                return boost::none;
+            if (buffer.size() == 0) {
                 step_ = step::content_end;
                 return get(ec);
             }
-            auto const nread = body_.read(buf_, n);
-            if (nread == 0) {
-                ec = http::error::short_read;
-                return boost::none;
-            }
-            BOOST_ASSERT(nread != 0);
-            *pos_ += nread;
-            ec = {};
-
-            return {{{buf_, nread}, true}};
+            return {{buffer, true}};
         } break;
         case step::content_end: {
             bool is_eof = (*range_index_) == body_.ranges.size() - 1;
@@ -112,6 +214,47 @@ file_body::writer::get(boost::system::error_code& ec)
     return boost::none;
 }
 
+net::const_buffer file_body::writer::read_content(std::uint64_t end, boost::system::error_code& ec)
+{
+    ec = {};
+    const auto& info = *body_.info;
+    auto remaining   = beast::detail::clamp(end - *pos_);
+    if (remaining == 0)
+        return {};
+
+    // in memory: the whole range at once, without copying.
+    if (info.loaded) {
+        net::const_buffer buffer(info.content.data() + *pos_, remaining);
+        *pos_ += remaining;
+        return buffer;
+    }
+
+    auto nread = info.read_at(*pos_, buf_, (std::min)(sizeof(buf_), remaining), ec);
+    if (ec)
+        return {};
+    if (nread == 0) {
+        ec = http::error::short_read;
+        return {};
+    }
+    *pos_ += nread;
+    return {buf_, nread};
+}
+
+file_body::upload_file::~upload_file()
+{
+    if (!path.empty()) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+void file_body::upload_file::move_to(const fs::path& target, std::error_code& ec)
+{
+    fs::rename(path, target, ec);
+    if (!ec)
+        path.clear();
+}
+
 file_body::reader::reader(const http::fields&, value_type& b)
     : body_(b)
 {
@@ -120,11 +263,142 @@ file_body::reader::reader(const http::fields&, value_type& b)
 void file_body::reader::init(boost::optional<std::uint64_t> const& content_length,
                              boost::system::error_code& ec)
 {
+    if (!body_.upload)
+        body_.upload = std::make_shared<upload_file>();
+    auto& upload = *body_.upload;
+
+    std::error_code std_ec;
+    if (upload.directory.empty())
+        upload.directory = fs::temp_directory_path(std_ec);
+    if (std_ec) {
+        ec.assign(std_ec.value(), boost::system::system_category());
+        return;
+    }
+    auto path = detail::unique_upload_path(upload.directory);
+
+#ifdef _WIN32
+    file_.open(path.string().c_str(), beast::file_mode::write_new, ec);
+    if (ec)
+        return;
+#else
+    int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    int fd    = -1;
+#ifdef O_DIRECT
+    // not every file system takes O_DIRECT (tmpfs does not), the page cache is the fallback.
+    if (upload.direct_io) {
+        fd = ::open(path.c_str(), flags | O_DIRECT, 0600);
+        if (fd != -1) {
+            staging_.reset(static_cast<char*>(
+                std::aligned_alloc(detail::direct_io_alignment, detail::staging_size)));
+            direct_ = true;
+        }
+    }
+#endif
+    if (fd == -1)
+        fd = ::open(path.c_str(), flags, 0600);
+    if (fd == -1) {
+        ec.assign(errno, boost::system::system_category());
+        return;
+    }
+    file_.native_handle(fd);
+#endif
+    upload.path = path;
+    upload.size = 0;
+
+    if (content_length && *content_length > upload.limit) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::file_too_large);
+        return;
+    }
+#ifdef __linux__
+    // reserve the blocks up front: less fragmentation, and a full disk shows up right away.
+    if (content_length && *content_length != 0 &&
+        ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(*content_length)) != 0 &&
+        errno != EOPNOTSUPP)
+    {
+        ec.assign(errno, boost::system::system_category());
+        return;
+    }
+#endif
+    if (direct_ && !staging_) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::not_enough_memory);
+        return;
+    }
+    ec = {};
+}
+
+std::size_t file_body::reader::put(const_buffers_type const& buffers,
+                                   boost::system::error_code& ec)
+{
+    if (buffers.size() > body_.upload->limit - body_.upload->size) {
+        ec = boost::system::errc::make_error_code(boost::system::errc::file_too_large);
+        return 0;
+    }
+    ec = {};
+    if (!direct_) {
+        write(buffers.data(), buffers.size(), ec);
+    }
+    else {
+        auto data = static_cast<const char*>(buffers.data());
+        auto n    = buffers.size();
+        while (n != 0 && !ec) {
+            auto bytes = (std::min)(n, detail::staging_size - staged_);
+            std::memcpy(staging_.get() + staged_, data, bytes);
+            staged_ += bytes;
+            data += bytes;
+            n -= bytes;
+            if (staged_ == detail::staging_size)
+                flush_staged(ec);
+        }
+    }
+    if (ec)
+        return 0;
+    body_.upload->size += buffers.size();
+    return buffers.size();
 }
 
 void file_body::reader::finish(boost::system::error_code& ec)
 {
-    ec.clear();
+    ec = {};
+    if (direct_)
+        flush_staged(ec);
+    if (ec)
+        return;
+    file_.close(ec);
+}
+
+void file_body::reader::write(const void* data, std::size_t n, boost::system::error_code& ec)
+{
+    auto p = static_cast<const char*>(data);
+    while (n != 0) {
+        auto bytes = file_.write(p, n, ec);
+        if (ec)
+            return;
+        if (bytes == 0) {
+            ec = boost::system::errc::make_error_code(boost::system::errc::io_error);
+            return;
+        }
+        p += bytes;
+        n -= bytes;
+    }
+}
+
+void file_body::reader::flush_staged(boost::system::error_code& ec)
+{
+    auto aligned = staged_ - staged_ % detail::direct_io_alignment;
+    if (aligned != 0)
+        write(staging_.get(), aligned, ec);
+    if (ec)
+        return;
+
+    // the end of the body is no whole block, it goes through the page cache.
+    if (aligned != staged_) {
+#ifdef O_DIRECT
+        auto fd = file_.native_handle();
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_DIRECT);
+#endif
+        write(staging_.get() + aligned, staged_ - aligned, ec);
+    }
+    staged_ = 0;
 }
 
 } // namespace httplib::body
\ No newline at end of file
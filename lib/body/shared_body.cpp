@@ -0,0 +1,43 @@
+#include "httplib/body/shared_body.hpp"
+
+namespace httplib::body {
+shared_body::writer::writer(const http::fields&, value_type const& b)
+    : body_(b)
+{
+}
+
+void shared_body::writer::init(beast::error_code& ec)
+{
+    ec = {};
+}
+
+boost::optional<std::pair<shared_body::writer::const_buffers_type, bool>>
+shared_body::writer::get(beast::error_code& ec)
+{
+    ec = {};
+    if (body_.size() == 0)
+        return boost::none;
+    return {{const_buffers_type {body_.data->data(), body_.data->size()}, false}};
+}
+
+shared_body::reader::reader(const http::fields&, value_type&)
+{
+}
+
+void shared_body::reader::init(boost::optional<std::uint64_t> const&, beast::error_code& ec)
+{
+    ec = {};
+}
+
+std::size_t shared_body::reader::put(net::const_buffer const&, beast::error_code& ec)
+{
+    ec = http::error::unexpected_body;
+    return 0;
+}
+
+void shared_body::reader::finish(beast::error_code& ec)
+{
+    ec = {};
+}
+
+} // namespace httplib::body
@@ -1,6 +1,8 @@
 #include "httplib/html/accept_content.hpp"
 #include "body/compressor.hpp"
 #include "httplib/util/misc.hpp"
+#include <boost/algorithm/string/predicate.hpp>
+#include <cstdlib>
 
 namespace httplib::html {
 
@@ -56,4 +58,21 @@ std::string accept_encoding_content::server_apply_encoding() const
     return {};
 }
 
+bool accept_encoding_content::accepts(std::string_view encoding) const
+{
+    auto is_refused = [](const header_element& elem) {
+        auto iter = elem.params.find("q");
+        return iter != elem.params.end() && std::strtod(iter->second.c_str(), nullptr) <= 0;
+    };
+
+    const header_element* wildcard = nullptr;
+    for (const auto& elem : elements_) {
+        if (boost::iequals(elem.value, encoding))
+            return !is_refused(elem);
+        if (elem.value == "*")
+            wildcard = &elem;
+    }
+    return wildcard && !is_refused(*wildcard);
+}
+
 } // namespace httplib::html
\ No newline at end of file
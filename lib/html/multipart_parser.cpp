@@ -0,0 +1,280 @@
+#include "httplib/html/multipart_parser.hpp"
+#include "httplib/util/misc.hpp"
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/beast/http/error.hpp>
+#include <cstring>
+
+namespace httplib::html {
+using namespace std::string_view_literals;
+
+namespace detail {
+
+// a part header larger than this is refused rather than buffered.
+static constexpr std::size_t max_part_header_size = 16 * 1024;
+
+static auto parse_content_disposition(std::string_view header)
+{
+    std::vector<std::pair<std::string_view, std::string_view>> results;
+
+    size_t pos = 0;
+    while (pos < header.size()) {
+        size_t eq = header.find('=', pos);
+        if (eq == std::string_view::npos)
+            break;
+
+        std::string_view key = header.substr(pos, eq - pos);
+        key                  = boost::trim_copy(key);
+        pos                  = eq + 1;
+
+        std::string_view value;
+        if (pos < header.size() && header[pos] == '"') {
+            pos++;
+            size_t end  = pos;
+            bool escape = false;
+            while (end < header.size()) {
+                if (header[end] == '\\' && !escape) {
+                    escape = true;
+                }
+                else if (header[end] == '"' && !escape) {
+                    break;
+                }
+                else {
+                    escape = false;
+                }
+                end++;
+            }
+            value = header.substr(pos, end - pos);
+            pos   = (end < header.size()) ? end + 1 : end;
+        }
+        else {
+            size_t end = header.find(';', pos);
+            if (end == std::string_view::npos)
+                end = header.size();
+            value = header.substr(pos, end - pos);
+            value = boost::trim_copy(value);
+            pos   = end;
+        }
+
+        results.emplace_back(key, value);
+
+        if (pos < header.size() && header[pos] == ';')
+            pos++;
+        while (pos < header.size() && std::isspace(header[pos]))
+            pos++;
+    }
+    return results;
+}
+
+static auto split_header_field_value(std::string_view header, boost::system::error_code& ec)
+{
+    std::vector<std::pair<std::string_view, std::string_view>> results;
+    auto lines = util::split(header, "\r\n"sv);
+
+    for (const auto& line : lines) {
+        if (line.empty())
+            continue;
+
+        auto pos = line.find(":");
+        if (pos == std::string_view::npos) {
+            ec = boost::beast::http::error::unexpected_body;
+            return decltype(results) {};
+        }
+
+        auto key   = boost::trim_copy(line.substr(0, pos));
+        auto value = boost::trim_copy(line.substr(pos + 1));
+        results.emplace_back(key, value);
+    }
+
+    return results;
+}
+
+} // namespace detail
+
+multipart_parser::multipart_parser(std::string_view boundary)
+    : delimiter_("\r\n--")
+    , pending_("\r\n")
+{
+    delimiter_ += boundary;
+
+    // Horspool: how far the window may move when its last byte is `c`.
+    skip_.fill(delimiter_.size());
+    for (std::size_t i = 0; i + 1 < delimiter_.size(); ++i)
+        skip_[static_cast<unsigned char>(delimiter_[i])] = delimiter_.size() - 1 - i;
+}
+
+std::string multipart_parser::boundary_from_content_type(std::string_view content_type)
+{
+    for (auto part : util::split(content_type, ";"sv)) {
+        part = boost::trim_copy(part);
+        if (!boost::istarts_with(part, "boundary="sv))
+            continue;
+
+        auto value = boost::trim_copy(part.substr("boundary="sv.size()));
+        if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+            value = value.substr(1, value.size() - 2);
+        return std::string(value);
+    }
+    return {};
+}
+
+void multipart_parser::put(std::string_view data, boost::system::error_code& ec)
+{
+    ec = {};
+    // the common case parses straight from the caller's buffer, only the tail that cannot be
+    // decided yet is copied.
+    if (pending_.empty()) {
+        auto n = parse(data, ec);
+        if (!ec)
+            pending_.assign(data.substr(n));
+        return;
+    }
+    pending_.append(data);
+    auto n = parse(pending_, ec);
+    if (!ec)
+        pending_.erase(0, n);
+}
+
+std::size_t multipart_parser::parse(std::string_view data, boost::system::error_code& ec)
+{
+    std::size_t pos = 0;
+    for (;;) {
+        switch (step_) {
+            case step::preamble:
+            case step::content: {
+                auto found = find_delimiter(data, pos);
+                auto end   = found;
+                if (found == std::string_view::npos)
+                    end = data.size() - partial_delimiter(data.substr(pos));
+                if (step_ == step::content && end != pos && on_part_data) {
+                    on_part_data(data.substr(pos, end - pos), ec);
+                    if (ec)
+                        return pos;
+                }
+                if (found == std::string_view::npos)
+                    return end;
+
+                if (step_ == step::content && on_part_end) {
+                    on_part_end(ec);
+                    if (ec)
+                        return pos;
+                }
+                pos   = found + delimiter_.size();
+                step_ = step::delimiter_end;
+            } break;
+            case step::delimiter_end: {
+                // "--" closes the body, otherwise optional padding and CRLF start the next part.
+                auto rest = data.substr(pos);
+                if (rest.size() < 2)
+                    return pos;
+                if (rest.starts_with("--"sv)) {
+                    pos += 2;
+                    step_ = step::epilogue;
+                    break;
+                }
+                auto crlf = rest.find_first_not_of(" \t");
+                if (crlf == std::string_view::npos || rest.size() - crlf < 2)
+                    return pos;
+                if (!rest.substr(crlf).starts_with("\r\n"sv)) {
+                    ec = boost::beast::http::error::unexpected_body;
+                    return pos;
+                }
+                pos += crlf + 2;
+                step_ = step::header;
+            } break;
+            case step::header: {
+                auto n = parse_header(data.substr(pos), ec);
+                if (ec || n == 0)
+                    return pos;
+                pos += n;
+                step_ = step::content;
+            } break;
+            case step::epilogue: return data.size();
+        }
+    }
+}
+
+std::size_t multipart_parser::parse_header(std::string_view data, boost::system::error_code& ec)
+{
+    std::size_t size = 0;
+    if (data.starts_with("\r\n"sv)) {
+        size = 2;
+    }
+    else {
+        auto pos = data.find("\r\n\r\n"sv);
+        if (pos == std::string_view::npos) {
+            if (data.size() > detail::max_part_header_size)
+                ec = boost::beast::http::error::header_limit;
+            return 0;
+        }
+        size = pos + 4;
+    }
+
+    auto results = detail::split_header_field_value(data.substr(0, size), ec);
+    if (ec)
+        return 0;
+
+    form_data::field part;
+    for (const auto& item : results) {
+        if (boost::iequals(item.first, "Content-Disposition"sv)) {
+            auto value = item.second;
+
+            auto pos = value.find(";");
+            if (pos == std::string_view::npos ||
+                boost::trim_copy(value.substr(0, pos)) != "form-data")
+            {
+                ec = boost::beast::http::error::unexpected_body;
+                return 0;
+            }
+            value.remove_prefix(pos + 1);
+
+            for (const auto& pair : detail::parse_content_disposition(value)) {
+                if (pair.first == "name") {
+                    part.name = pair.second;
+                }
+                else if (pair.first == "filename") {
+                    part.filename = pair.second;
+                }
+            }
+        }
+        else if (boost::iequals(item.first, "Content-Type"sv)) {
+            part.content_type = item.second;
+        }
+    }
+
+    if (on_part_begin) {
+        on_part_begin(part, ec);
+        if (ec)
+            return 0;
+    }
+    return size;
+}
+
+std::size_t multipart_parser::find_delimiter(std::string_view data, std::size_t pos) const
+{
+    const auto size = delimiter_.size();
+    const auto last = delimiter_.back();
+
+    while (pos + size <= data.size()) {
+        auto c = data[pos + size - 1];
+        if (c == last && std::memcmp(data.data() + pos, delimiter_.data(), size - 1) == 0)
+            return pos;
+        pos += skip_[static_cast<unsigned char>(c)];
+    }
+    return std::string_view::npos;
+}
+
+std::size_t multipart_parser::partial_delimiter(std::string_view data) const
+{
+    std::string_view delimiter = delimiter_;
+
+    auto pos = data.size() - std::min(data.size(), delimiter.size() - 1);
+    while ((pos = data.find('\r', pos)) != std::string_view::npos) {
+        if (delimiter.starts_with(data.substr(pos)))
+            return data.size() - pos;
+        ++pos;
+    }
+    return 0;
+}
+
+} // namespace httplib::html
@@ -1,4 +1,6 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <map>
 #include <string_view>
 
@@ -503,4 +505,30 @@ inline std::string_view get_mime_type(std::string_view extension)
 
     return it->second;
 }
+
+// text and structured text compress well; images, audio, video and archives are compressed
+// already.
+inline bool is_compressible(std::string_view mime_type)
+{
+    static constexpr std::array<std::string_view, 14> types = {
+        "application/javascript",
+        "application/x-javascript",
+        "application/ecmascript",
+        "application/json",
+        "application/xml",
+        "application/wasm",
+        "application/x-sh",
+        "application/rtf",
+        "application/postscript",
+        "application/vnd.ms-fontobject",
+        "font/ttf",
+        "font/otf",
+        "image/bmp",
+        "image/x-icon",
+    };
+    if (mime_type.starts_with("text/") || mime_type.ends_with("+json") ||
+        mime_type.ends_with("+xml"))
+        return true;
+    return std::find(types.begin(), types.end(), mime_type) != types.end();
+}
 } // namespace httplib::mime
@@ -0,0 +1,189 @@
+#include "access_log.hpp"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iterator>
+#include <spdlog/fmt/fmt.h>
+
+namespace httplib::server {
+
+namespace detail {
+
+static std::tm to_utc(std::time_t time)
+{
+    std::tm tm {};
+#ifdef _WIN32
+    gmtime_s(&tm, &time);
+#else
+    gmtime_r(&time, &tm);
+#endif
+    return tm;
+}
+
+static std::string_view method_string(http::verb method)
+{
+    if (method == http::verb::unknown)
+        return "-";
+    auto str = http::to_string(method);
+    return {str.data(), str.size()};
+}
+
+static std::string remote_address(const access_log::record& rec)
+{
+    if (rec.remote_v6)
+        return net::ip::address_v6(rec.remote_address).to_string();
+
+    net::ip::address_v4::bytes_type bytes;
+    std::copy_n(rec.remote_address.begin(), bytes.size(), bytes.begin());
+    return net::ip::address_v4(bytes).to_string();
+}
+
+// quotes, backslashes and control characters, enough for both the json and the common format.
+// json also gets bytes past ascii as \u00XX: a target is not checked to be valid utf-8.
+static void append_escaped(std::string& out, std::string_view value, bool json)
+{
+    for (char c : value) {
+        auto byte = static_cast<unsigned char>(c);
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (byte < 0x20 || (json && byte >= 0x80))
+                    fmt::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<int>(byte));
+                else
+                    out += c;
+                break;
+        }
+    }
+}
+
+} // namespace detail
+
+void access_log::record::set_remote(const tcp::endpoint& endp)
+{
+    remote_port = endp.port();
+    remote_v6   = endp.address().is_v6();
+    if (remote_v6) {
+        remote_address = endp.address().to_v6().to_bytes();
+    }
+    else {
+        auto bytes = endp.address().to_v4().to_bytes();
+        std::copy(bytes.begin(), bytes.end(), remote_address.begin());
+    }
+}
+
+void access_log::record::set_target(std::string_view value)
+{
+    target_size = static_cast<std::uint16_t>(std::min(value.size(), target.size()));
+    std::copy_n(value.data(), target_size, target.data());
+}
+
+access_log::access_log(const fs::path& file, access_log_format format, std::size_t capacity)
+    : format_(format)
+    , file_(file, std::ios::binary | std::ios::app)
+    , ring_(capacity)
+{
+    if (!file_)
+        throw std::runtime_error("Cannot open file: " + file.string());
+
+    thread_ = std::thread([this]() { run(); });
+}
+
+access_log::~access_log()
+{
+    stop_ = true;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void access_log::push(const record& rec) noexcept
+{
+    if (!ring_.try_push(rec))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t access_log::dropped() const noexcept
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+void access_log::run()
+{
+    using namespace std::chrono_literals;
+    static constexpr std::size_t batch_size = 64 * 1024;
+
+    std::string batch;
+    batch.reserve(batch_size + 1024);
+
+    record rec;
+    for (;;) {
+        // read the flag first, whatever was pushed before stopping is still written.
+        bool stopping = stop_;
+        while (batch.size() < batch_size && ring_.try_pop(rec))
+            format(rec, batch);
+
+        if (!batch.empty()) {
+            file_.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            file_.flush();
+            batch.clear();
+            continue;
+        }
+        if (stopping)
+            break;
+        std::this_thread::sleep_for(5ms);
+    }
+}
+
+void access_log::format(const record& rec, std::string& out) const
+{
+    auto time_us = std::chrono::microseconds(rec.time_us);
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(time_us);
+    auto tm      = detail::to_utc(static_cast<std::time_t>(seconds.count()));
+    auto target  = std::string_view(rec.target.data(), rec.target_size);
+
+    char time_str[64];
+    if (format_ == access_log_format::json) {
+        std::strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", &tm);
+        fmt::format_to(std::back_inserter(out),
+                       R"({{"time":"{}.{:06}Z","remote":"{}","remote_port":{},"local_port":{},)"
+                       R"("method":"{}","target":")",
+                       time_str,
+                       (time_us - seconds).count(),
+                       detail::remote_address(rec),
+                       rec.remote_port,
+                       rec.local_port,
+                       detail::method_string(rec.method));
+        detail::append_escaped(out, target, true);
+        fmt::format_to(std::back_inserter(out),
+                       R"(","version":"{}.{}","status":{},"bytes":{},"duration_us":{},)"
+                       R"("handler_us":{}}})"
+                       "\n",
+                       rec.version / 10,
+                       rec.version % 10,
+                       rec.status,
+                       rec.bytes_sent,
+                       rec.duration_us,
+                       rec.handler_us);
+        return;
+    }
+
+    // common log format: host ident authuser [date] "request" status bytes
+    std::strftime(time_str, sizeof(time_str), "%d/%b/%Y:%H:%M:%S +0000", &tm);
+    fmt::format_to(std::back_inserter(out),
+                   "{} - - [{}] \"{} ",
+                   detail::remote_address(rec),
+                   time_str,
+                   detail::method_string(rec.method));
+    detail::append_escaped(out, target, false);
+    fmt::format_to(
+        std::back_inserter(out), " HTTP/{}.{}\" {} ", rec.version / 10, rec.version % 10, rec.status);
+    if (rec.bytes_sent == 0)
+        out += "-\n";
+    else
+        fmt::format_to(std::back_inserter(out), "{}\n", rec.bytes_sent);
+}
+
+} // namespace httplib::server
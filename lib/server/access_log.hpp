@@ -0,0 +1,66 @@
+#pragma once
+#include "httplib/config.hpp"
+#include "httplib/server/server.hpp"
+#include "util/mpmc_ring.hpp"
+#include <array>
+#include <atomic>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/http/verb.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace httplib::server {
+
+// Access log kept off the request path: I/O threads copy a fixed size record into a lock-free
+// ring, a background thread formats the records and writes them to the file in batches. A full
+// ring drops the record and counts it, a request never waits for the log.
+class access_log
+{
+public:
+    struct record
+    {
+        std::int64_t time_us       = 0; // system clock, when the request header was received
+        std::uint32_t duration_us  = 0; // header received -> response written
+        std::uint32_t handler_us   = 0;
+        std::uint64_t bytes_sent   = 0;
+        std::uint16_t status       = 0;
+        std::uint16_t remote_port  = 0;
+        std::uint16_t local_port   = 0;
+        std::uint16_t target_size  = 0;
+        std::uint8_t version       = 11;
+        bool remote_v6             = false;
+        http::verb method          = http::verb::unknown;
+        std::array<std::uint8_t, 16> remote_address {};
+        std::array<char, 400> target {};
+
+        void set_remote(const tcp::endpoint& endp);
+        void set_target(std::string_view value);
+    };
+
+public:
+    explicit access_log(const fs::path& file,
+                        access_log_format format,
+                        std::size_t capacity = 8192);
+    ~access_log();
+
+    void push(const record& rec) noexcept;
+    std::uint64_t dropped() const noexcept;
+
+private:
+    void run();
+    void format(const record& rec, std::string& out) const;
+
+private:
+    access_log_format format_;
+    std::ofstream file_;
+
+    util::mpmc_ring<record> ring_;
+    std::atomic_uint64_t dropped_ = 0;
+
+    std::atomic_bool stop_ = false;
+    std::thread thread_;
+};
+
+} // namespace httplib::server
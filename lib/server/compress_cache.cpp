@@ -0,0 +1,177 @@
+#include "httplib/server/compress_cache.hpp"
+#include "compression.hpp"
+#include "httplib/html/accept_content.hpp"
+#include "httplib/server/request.hpp"
+#include "httplib/server/response.hpp"
+#include <atomic>
+#include <fmt/format.h>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace httplib::server {
+
+class compress_cache::impl
+{
+public:
+    explicit impl(std::size_t max_bytes)
+        : max_bytes_(max_bytes)
+    {
+    }
+
+    std::shared_ptr<const std::string> find(std::string_view key)
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        auto iter = index_.find(key);
+        if (iter == index_.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        lru_.splice(lru_.begin(), lru_, iter->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return iter->second->data;
+    }
+
+    void insert(std::string&& key, std::shared_ptr<const std::string> data)
+    {
+        // a key holding the body counts against the budget like the compressed bytes.
+        if (key.size() + data->size() > max_bytes_)
+            return;
+
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (index_.count(key) != 0)
+            return;
+
+        used_ += key.size() + data->size();
+        lru_.push_front(node {std::move(key), std::move(data)});
+        index_.emplace(lru_.front().key, lru_.begin());
+        while (used_ > max_bytes_) {
+            auto& last = lru_.back();
+            used_ -= last.key.size() + last.data->size();
+            index_.erase(last.key);
+            lru_.pop_back();
+        }
+    }
+
+    std::uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    std::uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    std::size_t memory_used() const
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        return used_;
+    }
+
+private:
+    struct node
+    {
+        std::string key;
+        std::shared_ptr<const std::string> data;
+    };
+
+    const std::size_t max_bytes_;
+
+    mutable std::mutex mutex_;
+    std::list<node> lru_;
+    // keys point into the nodes.
+    std::unordered_map<std::string_view, std::list<node>::iterator> index_;
+    std::size_t used_ = 0;
+
+    std::atomic_uint64_t hits_   = 0;
+    std::atomic_uint64_t misses_ = 0;
+};
+
+compress_cache::compress_cache(std::size_t max_bytes /*= 64 * 1024 * 1024*/,
+                               compression_policy policy /*= {}*/)
+    : impl_(std::make_shared<impl>(max_bytes))
+    , policy_(std::make_shared<const compression_policy>(std::move(policy)))
+{
+}
+
+bool compress_cache::after(request& req, response& resp)
+{
+    // only complete, plain bodies: streams, files and encoded responses are left alone.
+    const auto& content = resp.body();
+    if (resp.result() != http::status::ok || resp.chunked() ||
+        resp.find(http::field::content_encoding) != resp.end() ||
+        content.is_body_type<body::empty_body>() || content.is_body_type<body::file_body>() ||
+        content.is_body_type<body::shared_body>())
+        return true;
+
+    const auto& policy =
+        resp.get_compression_policy() ? *resp.get_compression_policy() : *policy_;
+    auto content_type = resp[http::field::content_type];
+    auto compressible = [&](std::optional<std::uint64_t> size) {
+        return policy.should_compress({content_type.data(), content_type.size()}, size);
+    };
+    if (!compressible(std::nullopt))
+        return true;
+
+    auto accept = req.find(http::field::accept_encoding);
+    if (accept == req.end())
+        return true;
+    html::accept_encoding_content encoding_content;
+    if (!encoding_content.parse({accept->value().data(), accept->value().size()}))
+        return true;
+    auto encoding = encoding_content.server_apply_encoding();
+    if (encoding.empty())
+        return true;
+
+    // with an ETag the body does not even have to be looked at on a hit. Without one the key
+    // is the body itself, a hit compares it whole.
+    std::string key;
+    std::string_view data;
+    std::string collected;
+    auto etag = resp.find(http::field::etag);
+    if (etag != resp.end()) {
+        key = fmt::format("{}\n{}\n{}",
+                          std::string_view(req.target().data(), req.target().size()),
+                          std::string_view(etag->value().data(), etag->value().size()),
+                          encoding);
+    }
+    else {
+        key = fmt::format("#{}\n", encoding);
+        auto prefix = key.size();
+        if (!collect_body(resp, key))
+            return true;
+        data = std::string_view(key).substr(prefix);
+        if (!compressible(data.size()))
+            return true;
+    }
+
+    auto compressed = impl_->find(key);
+    if (!compressed) {
+        if (etag != resp.end()) {
+            if (!collect_body(resp, collected) || !compressible(collected.size()))
+                return true;
+            data = collected;
+        }
+        compressed = compress_body(encoding, data);
+        if (!compressed)
+            return true;
+        impl_->insert(std::move(key), compressed);
+    }
+
+    auto size = compressed->size();
+    resp.body() = body::shared_body::value_type {std::move(compressed), true};
+    resp.set(http::field::content_encoding, encoding);
+    add_vary(resp);
+    resp.content_length(size);
+    return true;
+}
+
+std::uint64_t compress_cache::hits() const
+{
+    return impl_->hits();
+}
+
+std::uint64_t compress_cache::misses() const
+{
+    return impl_->misses();
+}
+
+std::size_t compress_cache::memory_used() const
+{
+    return impl_->memory_used();
+}
+
+} // namespace httplib::server
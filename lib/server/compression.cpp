@@ -0,0 +1,223 @@
+#include "compression.hpp"
+#include "body/compressor.hpp"
+#include "file_reader.hpp"
+#include "httplib/html/accept_content.hpp"
+#include "httplib/server/request.hpp"
+#include "httplib/server/response.hpp"
+#include "mime_types.hpp"
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <algorithm>
+#include <charconv>
+
+namespace httplib::server {
+
+namespace detail {
+
+static bool match_type(std::string_view pattern, std::string_view type)
+{
+    if (pattern.ends_with("/*"))
+        return type.starts_with(pattern.substr(0, pattern.size() - 1));
+    return pattern == type;
+}
+
+static bool match_any(const std::vector<std::string>& patterns, std::string_view type)
+{
+    return std::any_of(patterns.begin(), patterns.end(), [&](const std::string& pattern) {
+        return match_type(pattern, type);
+    });
+}
+
+static std::optional<std::uint64_t> content_length(const response& resp)
+{
+    auto iter = resp.find(http::field::content_length);
+    if (iter == resp.end())
+        return std::nullopt;
+
+    std::uint64_t value = 0;
+    auto str            = iter->value();
+    auto result         = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (result.ec != std::errc() || result.ptr != str.data() + str.size())
+        return std::nullopt;
+    return value;
+}
+
+// a file not held in memory, its content comes from the disk.
+static bool is_disk_file(const response& resp)
+{
+    const auto& content = resp.body();
+    if (!content.is_body_type<body::file_body>())
+        return false;
+    const auto& file = content.as<body::file_body>();
+    return file.info && !file.info->loaded && file.ranges.empty();
+}
+
+// the content-coding to apply, empty for none. Vary is set whenever the answer depended on
+// Accept-Encoding.
+static std::string negotiate(const compression_policy& policy,
+                             const request& req,
+                             response& resp,
+                             std::optional<std::uint64_t> size)
+{
+    // already encoded (precompressed files, compress_cache), partial or without a body.
+    const auto& content = resp.body();
+    if (resp.find(http::field::content_encoding) != resp.end() ||
+        resp.result() == http::status::partial_content ||
+        content.is_body_type<body::empty_body>())
+        return {};
+
+    auto content_type = resp[http::field::content_type];
+    if (!policy.should_compress({content_type.data(), content_type.size()}, size))
+        return {};
+
+    // the representation depends on Accept-Encoding from here on, whatever this client sent.
+    add_vary(resp);
+
+    // nothing of a HEAD response is sent, compressing it would be for nothing.
+    if (req.method() == http::verb::head)
+        return {};
+
+    auto accept = req.find(http::field::accept_encoding);
+    if (accept == req.end())
+        return {};
+    html::accept_encoding_content encoding_content;
+    if (!encoding_content.parse({accept->value().data(), accept->value().size()}))
+        return {};
+    return encoding_content.server_apply_encoding();
+}
+
+static compression_mode
+set_compressed(response& resp, const std::string& encoding, std::string_view data)
+{
+    auto compressed = compress_body(encoding, data);
+    if (!compressed) {
+        resp.set(http::field::content_encoding, encoding);
+        return compression_mode::streamed;
+    }
+    auto compressed_size = compressed->size();
+    resp.body() = body::shared_body::value_type {std::move(compressed), true};
+    resp.set(http::field::content_encoding, encoding);
+    resp.content_length(compressed_size);
+    return compression_mode::buffered;
+}
+
+} // namespace detail
+
+void add_vary(response& resp)
+{
+    auto iter = resp.find(http::field::vary);
+    if (iter == resp.end()) {
+        resp.set(http::field::vary, "Accept-Encoding");
+        return;
+    }
+    auto value = boost::algorithm::to_lower_copy(std::string(iter->value()));
+    if (value.find("accept-encoding") == std::string::npos && value.find('*') == std::string::npos)
+        resp.set(http::field::vary, std::string(iter->value()) + ", Accept-Encoding");
+}
+
+bool compression_policy::should_compress(std::string_view content_type,
+                                         std::optional<std::uint64_t> size) const
+{
+    if (!enabled || (size && *size < min_size))
+        return false;
+
+    auto type = boost::algorithm::to_lower_copy(
+        boost::algorithm::trim_copy(std::string(content_type.substr(0, content_type.find(';')))));
+    if (type.empty() || detail::match_any(deny_types, type))
+        return false;
+    if (allow_types.empty())
+        return mime::is_compressible(type);
+    return detail::match_any(allow_types, type);
+}
+
+compression_override::compression_override(compression_policy policy)
+    : policy_(std::make_shared<const compression_policy>(std::move(policy)))
+{
+}
+
+bool compression_override::after(request& req, response& resp)
+{
+    resp.set_compression_policy(policy_);
+    return true;
+}
+
+bool collect_body(response& resp, std::string& out)
+{
+    boost::system::error_code ec;
+    body::any_body::writer writer(resp, resp.body());
+    writer.init(ec);
+    while (!ec) {
+        auto result = writer.get(ec);
+        if (ec || !result)
+            break;
+        out.append(static_cast<const char*>(result->first.data()), result->first.size());
+        if (!result->second)
+            break;
+    }
+    return !ec;
+}
+
+std::shared_ptr<const std::string> compress_body(const std::string& encoding,
+                                                 std::string_view data)
+{
+    auto compressor = body::compressor_factory::instance().create(encoding);
+    if (!compressor)
+        return nullptr;
+
+    compressor->init(body::compressor::mode::encode);
+    compressor->write(net::buffer(data.data(), data.size()), false);
+    auto buffer = compressor->buffer();
+    return std::make_shared<const std::string>(static_cast<const char*>(buffer.data()),
+                                               buffer.size());
+}
+
+compression_mode
+apply_compression(const compression_policy& policy, const request& req, response& resp)
+{
+    auto size     = detail::content_length(resp);
+    auto encoding = detail::negotiate(policy, req, resp, size);
+    if (encoding.empty())
+        return compression_mode::none;
+
+    if (size && *size <= policy.max_buffered_size) {
+        std::string data;
+        if (collect_body(resp, data))
+            return detail::set_compressed(resp, encoding, data);
+    }
+    resp.set(http::field::content_encoding, encoding);
+    return compression_mode::streamed;
+}
+
+net::awaitable<compression_mode>
+async_apply_compression(const compression_policy& policy, const request& req, response& resp)
+{
+    if (!detail::is_disk_file(resp))
+        co_return apply_compression(policy, req, resp);
+
+    auto size     = detail::content_length(resp);
+    auto encoding = detail::negotiate(policy, req, resp, size);
+    if (encoding.empty())
+        co_return compression_mode::none;
+
+    if (size && *size <= policy.max_buffered_size) {
+        const auto& info = resp.body().as<body::file_body>().info;
+        file_reader reader(co_await net::this_coro::executor, info);
+
+        std::string data(static_cast<std::size_t>(*size), '\0');
+        std::size_t offset = 0;
+        boost::system::error_code ec;
+        while (offset < data.size()) {
+            auto bytes = co_await reader.async_read_some_at(
+                offset, net::buffer(data.data() + offset, data.size() - offset), ec);
+            if (ec || bytes == 0)
+                break;
+            offset += bytes;
+        }
+        if (offset == data.size())
+            co_return detail::set_compressed(resp, encoding, data);
+    }
+    resp.set(http::field::content_encoding, encoding);
+    co_return compression_mode::streamed;
+}
+
+} // namespace httplib::server
@@ -0,0 +1,35 @@
+#pragma once
+#include "httplib/server/compression_policy.hpp"
+#include <boost/asio/awaitable.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace httplib::server {
+
+// the uncompressed body, as the serializer would produce it.
+bool collect_body(response& resp, std::string& out);
+
+// adds Accept-Encoding to Vary, keeping what is there.
+void add_vary(response& resp);
+
+std::shared_ptr<const std::string> compress_body(const std::string& encoding,
+                                                 std::string_view data);
+
+enum class compression_mode
+{
+    none,
+    // the body was replaced by its compressed bytes, Content-Length is kept.
+    buffered,
+    // Content-Encoding is set, the serializer compresses: the caller drops the length.
+    streamed,
+};
+
+// Content-Encoding negotiation of a complete (not streamed) response.
+compression_mode
+apply_compression(const compression_policy& policy, const request& req, response& resp);
+// the same, a file body to compress is read with file_reader instead of on the calling thread.
+net::awaitable<compression_mode>
+async_apply_compression(const compression_policy& policy, const request& req, response& resp);
+
+} // namespace httplib::server
@@ -0,0 +1,125 @@
+#include "connection_limiter.hpp"
+#include "httplib/util/use_awaitable.hpp"
+#include <boost/asio/post.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <algorithm>
+
+namespace httplib::server {
+
+void connection_limiter::set_max_connections(std::size_t count)
+{
+    max_connections_ = count;
+}
+
+void connection_limiter::set_max_connections_per_ip(std::size_t count)
+{
+    max_connections_per_ip_ = count;
+}
+
+void connection_limiter::set_reject_on_overload(bool enabled)
+{
+    reject_on_overload_ = enabled;
+}
+
+std::size_t connection_limiter::max_connections() const
+{
+    return max_connections_;
+}
+
+std::size_t connection_limiter::max_connections_per_ip() const
+{
+    return max_connections_per_ip_;
+}
+
+bool connection_limiter::reject_on_overload() const
+{
+    return reject_on_overload_;
+}
+
+std::size_t connection_limiter::active_connections() const
+{
+    return active_.load(std::memory_order_relaxed);
+}
+
+bool connection_limiter::try_acquire()
+{
+    auto max_count = max_connections_.load(std::memory_order_relaxed);
+    auto count     = active_.fetch_add(1, std::memory_order_acq_rel);
+    if (max_count != 0 && count >= max_count) {
+        active_.fetch_sub(1, std::memory_order_acq_rel);
+        return false;
+    }
+    return true;
+}
+
+void connection_limiter::release()
+{
+    active_.fetch_sub(1, std::memory_order_acq_rel);
+    wake_waiters();
+}
+
+void connection_limiter::wake_waiters()
+{
+    if (waiter_count_.load(std::memory_order_acquire) == 0)
+        return;
+
+    std::lock_guard lck(waiter_mutex_);
+    for (const auto& timer : waiters_)
+        net::post(timer->get_executor(), [timer]() { timer->cancel(); });
+    waiters_.clear();
+    waiter_count_ = 0;
+}
+
+bool connection_limiter::try_acquire_address(const net::ip::address& address)
+{
+    auto max_count = max_connections_per_ip_.load(std::memory_order_relaxed);
+    if (max_count == 0)
+        return true;
+
+    std::lock_guard lck(address_mutex_);
+    auto& count = address_count_[address];
+    if (count >= max_count)
+        return false;
+    ++count;
+    return true;
+}
+
+void connection_limiter::release_address(const net::ip::address& address)
+{
+    if (max_connections_per_ip_.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::lock_guard lck(address_mutex_);
+    auto iter = address_count_.find(address);
+    if (iter == address_count_.end())
+        return;
+
+    if (--iter->second == 0)
+        address_count_.erase(iter);
+}
+
+net::awaitable<void> connection_limiter::async_wait_slot()
+{
+    auto timer = std::make_shared<net::steady_timer>(co_await net::this_coro::executor);
+    // safety net, a release normally wakes us up long before.
+    timer->expires_after(std::chrono::seconds(1));
+    {
+        std::lock_guard lck(waiter_mutex_);
+        if (active_.load(std::memory_order_acquire) < max_connections_.load())
+            co_return;
+
+        waiters_.push_back(timer);
+        waiter_count_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    boost::system::error_code ec;
+    co_await timer->async_wait(util::net_awaitable[ec]);
+
+    std::lock_guard lck(waiter_mutex_);
+    if (auto iter = std::ranges::find(waiters_, timer); iter != waiters_.end()) {
+        waiters_.erase(iter);
+        waiter_count_.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+} // namespace httplib::server
@@ -0,0 +1,55 @@
+#pragma once
+#include "httplib/config.hpp"
+#include <atomic>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/ip/address.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <vector>
+
+namespace httplib::server {
+
+// Admission control for accepted connections: a global and a per remote address limit.
+// Acceptors that hit the global limit park in `async_wait_slot()` and are woken up as soon as
+// a connection is released.
+class connection_limiter
+{
+public:
+    void set_max_connections(std::size_t count);
+    void set_max_connections_per_ip(std::size_t count);
+    void set_reject_on_overload(bool enabled);
+
+    std::size_t max_connections() const;
+    std::size_t max_connections_per_ip() const;
+    bool reject_on_overload() const;
+
+    std::size_t active_connections() const;
+
+    bool try_acquire();
+    void release();
+
+    bool try_acquire_address(const net::ip::address& address);
+    void release_address(const net::ip::address& address);
+
+    net::awaitable<void> async_wait_slot();
+    // ends every async_wait_slot() now, whether a slot is free or not.
+    void wake_waiters();
+
+private:
+    std::atomic_size_t max_connections_        = 0;
+    std::atomic_size_t max_connections_per_ip_ = 0;
+    std::atomic_bool reject_on_overload_       = false;
+
+    std::atomic_size_t active_ = 0;
+
+    std::mutex address_mutex_;
+    std::map<net::ip::address, std::size_t> address_count_;
+
+    std::mutex waiter_mutex_;
+    std::atomic_size_t waiter_count_ = 0;
+    std::vector<std::shared_ptr<net::steady_timer>> waiters_;
+};
+
+} // namespace httplib::server
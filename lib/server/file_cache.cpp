@@ -0,0 +1,259 @@
+#include "file_cache.hpp"
+#include "html/html.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace httplib::server {
+
+namespace detail {
+
+// how often the inotify queue is read, changes are noticed at most this late.
+static constexpr auto inotify_poll_interval = std::chrono::milliseconds(100);
+
+static std::size_t memory_size(const body::file_body::file_info* info)
+{
+    return info && info->loaded ? info->content.size() : 0;
+}
+
+} // namespace detail
+
+file_cache::file_cache(std::size_t capacity,
+                       const std::chrono::steady_clock::duration& ttl,
+                       std::size_t memory_budget /*= 0*/,
+                       std::size_t max_memory_file_size /*= 0*/)
+    : capacity_(capacity)
+    , ttl_(ttl)
+    , memory_budget_(memory_budget)
+    , max_memory_file_size_(memory_budget == 0 ? 0 : max_memory_file_size)
+{
+#ifdef __linux__
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+file_cache::~file_cache()
+{
+#ifdef __linux__
+    if (inotify_fd_ != -1)
+        ::close(inotify_fd_);
+#endif
+}
+
+file_cache::file_info_ptr file_cache::get(const fs::path& path,
+                                          std::string_view content_encoding /*= {}*/)
+{
+    // a precompressed variant is served as its encoding, the same file fetched directly is not.
+    auto key = path.string();
+    key += '\0';
+    key += content_encoding;
+    auto now = std::chrono::steady_clock::now();
+
+    poll_changes(now);
+
+    file_info_ptr stale;
+    std::uint64_t changes = 0;
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        changes = changes_;
+        if (auto iter = index_.find(key); iter != index_.end()) {
+            auto& list = list_of(*iter->second);
+            list.splice(list.begin(), list, iter->second);
+            if (is_fresh(*iter->second, now))
+                return iter->second->info;
+            stale = iter->second->info;
+        }
+    }
+
+    // file system calls are made without the lock.
+    if (stale && is_unchanged(path, *stale)) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        if (auto iter = index_.find(key); iter != index_.end() && iter->second->info == stale) {
+            // its watch has been registered since the entry was inserted, from now on every
+            // change drops it.
+            iter->second->checked = now;
+            iter->second->watched = iter->second->watch != -1;
+        }
+        return stale;
+    }
+
+    // watched before the file is read, a write while it is read is reported.
+    auto watch = add_watch(path);
+
+    boost::system::error_code ec;
+    auto info = body::file_body::file_info::open(path, ec, content_encoding);
+    if (info && info->size <= max_memory_file_size_) {
+        info->load(ec);
+        if (ec)
+            info->content.clear();
+    }
+
+    // an event for the watch may have been read by another caller before the entry existed
+    // to drop. Whenever some were read meanwhile, the entry is checked once after the ttl.
+    std::lock_guard<std::mutex> lck(mutex_);
+    insert(std::move(key), info, watch, changes == changes_, now);
+    return info;
+}
+
+bool file_cache::is_unchanged(const fs::path& path, const body::file_body::file_info& info)
+{
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (ec || size != info.size)
+        return false;
+    auto last_write_time = html::file_last_write_time(path, ec);
+    return !ec && last_write_time == info.last_write_time;
+}
+
+bool file_cache::is_fresh(const node& n, std::chrono::steady_clock::time_point now) const
+{
+    // a watched file is dropped when it changes, it never needs to be checked.
+    return n.watched || now - n.checked < ttl_;
+}
+
+void file_cache::insert(std::string key,
+                        file_info_ptr info,
+                        int watch,
+                        bool watched,
+                        std::chrono::steady_clock::time_point now)
+{
+    // a miss needs no watch; a watch other entries share stays.
+    if (!info && watch != -1) {
+#ifdef __linux__
+        if (watches_.count(watch) == 0)
+            ::inotify_rm_watch(inotify_fd_, watch);
+#endif
+        watch = -1;
+    }
+
+    // registered first: the entry replaced may hold the same watch, it must not be removed.
+    if (watch != -1)
+        watches_.emplace(watch, key);
+    if (auto iter = index_.find(key); iter != index_.end())
+        erase(iter->second);
+
+    memory_used_ += detail::memory_size(info.get());
+    auto& list = info ? lru_ : misses_;
+    list.push_front(node {key, std::move(info), now, watch, watch != -1 && watched});
+    index_.emplace(std::move(key), list.begin());
+
+    while (lru_.size() > capacity_)
+        erase(std::prev(lru_.end()));
+    while (misses_.size() > capacity_)
+        erase(std::prev(misses_.end()));
+
+    // over the memory budget: the least recently used files held in memory go first.
+    auto iter = lru_.end();
+    while (memory_used_ > memory_budget_ && iter != lru_.begin()) {
+        auto victim = std::prev(iter);
+        if (detail::memory_size(victim->info.get()) == 0)
+            iter = victim;
+        else
+            erase(victim);
+    }
+}
+
+void file_cache::erase(node_list::iterator iter)
+{
+    if (iter->watch != -1)
+        remove_watch(iter->watch, iter->key);
+    memory_used_ -= detail::memory_size(iter->info.get());
+    index_.erase(iter->key);
+    list_of(*iter).erase(iter);
+}
+
+int file_cache::add_watch(const fs::path& path)
+{
+#ifdef __linux__
+    if (inotify_fd_ == -1)
+        return -1;
+
+    // IN_ATTRIB also covers the link count dropping, a file replaced by rename.
+    return ::inotify_add_watch(
+        inotify_fd_, path.c_str(), IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+#else
+    return -1;
+#endif
+}
+
+void file_cache::remove_watch(int watch, const std::string& key)
+{
+    auto [first, last] = watches_.equal_range(watch);
+    for (auto iter = first; iter != last; ++iter) {
+        if (iter->second == key) {
+            watches_.erase(iter);
+            break;
+        }
+    }
+#ifdef __linux__
+    // one watch per inode, hard links share it.
+    if (watches_.count(watch) == 0)
+        ::inotify_rm_watch(inotify_fd_, watch);
+#endif
+}
+
+void file_cache::poll_changes(std::chrono::steady_clock::time_point now)
+{
+#ifdef __linux__
+    if (inotify_fd_ == -1)
+        return;
+
+    // one caller per interval reads the queue, and does so without the lock.
+    static constexpr auto interval =
+        std::chrono::steady_clock::duration(detail::inotify_poll_interval).count();
+    auto ticks  = now.time_since_epoch().count();
+    auto polled = polled_.load(std::memory_order_relaxed);
+    if (ticks - polled < interval ||
+        !polled_.compare_exchange_strong(polled, ticks, std::memory_order_relaxed))
+        return;
+
+    std::vector<int> changed;
+    bool overflow = false;
+    alignas(inotify_event) char buffer[4096];
+    for (;;) {
+        auto bytes = ::read(inotify_fd_, buffer, sizeof(buffer));
+        if (bytes <= 0)
+            break;
+
+        for (char* ptr = buffer; ptr < buffer + bytes;) {
+            auto* event = reinterpret_cast<inotify_event*>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
+                overflow = true;
+            else
+                changed.push_back(event->wd);
+        }
+    }
+    if (changed.empty() && !overflow)
+        return;
+
+    // a watch removed while a new entry was adding it is reported as IN_IGNORED, the entry
+    // is dropped here with the others.
+    std::lock_guard<std::mutex> lck(mutex_);
+    ++changes_;
+    if (overflow) {
+        // events were lost, no watched entry can be trusted.
+        for (auto iter = lru_.begin(); iter != lru_.end();) {
+            auto next = std::next(iter);
+            if (iter->watch != -1)
+                erase(iter);
+            iter = next;
+        }
+        return;
+    }
+    for (auto watch : changed) {
+        std::vector<std::string> keys;
+        auto [first, last] = watches_.equal_range(watch);
+        for (auto iter = first; iter != last; ++iter)
+            keys.push_back(iter->second);
+        for (const auto& key : keys) {
+            if (auto iter = index_.find(key); iter != index_.end() && iter->second->watch == watch)
+                erase(iter->second);
+        }
+    }
+#endif
+}
+
+} // namespace httplib::server
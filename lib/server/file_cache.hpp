@@ -0,0 +1,84 @@
+#pragma once
+#include "httplib/body/file_body.hpp"
+#include "httplib/config.hpp"
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace httplib::server {
+
+// Open files of a static mount point with their metadata, least recently used out, and as many
+// paths that are not there besides. Every request for a hot file shares one handle, small
+// files can be kept in memory within a byte budget. On Linux a cached file is watched with inotify and dropped as soon as it changes;
+// elsewhere, and for misses, an entry older than the ttl is checked against the file system
+// again (size and modification time) before it is handed out.
+class file_cache
+{
+public:
+    using file_info_ptr = std::shared_ptr<const body::file_body::file_info>;
+
+    file_cache(std::size_t capacity,
+               const std::chrono::steady_clock::duration& ttl,
+               std::size_t memory_budget        = 0,
+               std::size_t max_memory_file_size = 0);
+    ~file_cache();
+
+    // nullptr when `path` is not a readable regular file.
+    file_info_ptr get(const fs::path& path, std::string_view content_encoding = {});
+
+private:
+    struct node
+    {
+        std::string key;
+        file_info_ptr info;
+        std::chrono::steady_clock::time_point checked;
+        int watch = -1;
+        // no change can have gone unnoticed since the file was read: the entry is only dropped
+        // by its watch, never checked against the file system.
+        bool watched = false;
+    };
+    using node_list = std::list<node>;
+
+    // misses are kept apart, a precompressed mount looks up three variants that are mostly not
+    // there for every file and they must not push the files themselves out.
+    node_list& list_of(const node& n) { return n.info ? lru_ : misses_; }
+
+    static bool is_unchanged(const fs::path& path, const body::file_body::file_info& info);
+    bool is_fresh(const node& n, std::chrono::steady_clock::time_point now) const;
+
+    void insert(std::string key,
+                file_info_ptr info,
+                int watch,
+                bool watched,
+                std::chrono::steady_clock::time_point now);
+    void erase(node_list::iterator iter);
+
+    int add_watch(const fs::path& path);
+    void remove_watch(int watch, const std::string& key);
+    void poll_changes(std::chrono::steady_clock::time_point now);
+
+private:
+    const std::size_t capacity_;
+    const std::chrono::steady_clock::duration ttl_;
+    const std::size_t memory_budget_;
+    const std::size_t max_memory_file_size_;
+
+    std::mutex mutex_;
+    node_list lru_;
+    node_list misses_;
+    std::unordered_map<std::string, node_list::iterator> index_;
+    std::size_t memory_used_ = 0;
+
+    int inotify_fd_ = -1;
+    std::unordered_multimap<int, std::string> watches_;
+    // inotify batches handled so far, see get().
+    std::uint64_t changes_ = 0;
+    std::atomic<std::chrono::steady_clock::rep> polled_ = 0;
+};
+
+} // namespace httplib::server
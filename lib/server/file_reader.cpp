@@ -0,0 +1,96 @@
+#include "file_reader.hpp"
+#include "httplib/util/use_awaitable.hpp"
+#include <algorithm>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <thread>
+
+#ifdef HTTPLIB_FILE_READER_IO_URING
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <cerrno>
+#include <sys/uio.h>
+#endif
+
+namespace httplib::server {
+
+namespace detail {
+
+static net::thread_pool& blocking_pool()
+{
+    static net::thread_pool pool((std::max)(2u, std::thread::hardware_concurrency() / 2));
+    return pool;
+}
+
+#if defined(__linux__) && defined(RWF_NOWAIT)
+// what the page cache holds is read in place, without a hop to the pool.
+static bool read_cached(int fd,
+                        std::uint64_t offset,
+                        net::mutable_buffer buffer,
+                        std::size_t& bytes,
+                        boost::system::error_code& ec)
+{
+    iovec iov {buffer.data(), buffer.size()};
+    auto result = ::preadv2(fd, &iov, 1, static_cast<off_t>(offset), RWF_NOWAIT);
+    if (result < 0) {
+        // EAGAIN: not cached. EOPNOTSUPP: the file system does not do RWF_NOWAIT.
+        if (errno == EAGAIN || errno == EOPNOTSUPP || errno == ENOSYS || errno == EINTR)
+            return false;
+        ec.assign(errno, boost::system::system_category());
+        bytes = 0;
+        return true;
+    }
+    // short when only the start of the range is cached, the pool reads the rest next time.
+    ec    = {};
+    bytes = static_cast<std::size_t>(result);
+    return true;
+}
+#endif
+
+} // namespace detail
+
+file_reader::file_reader(const net::any_io_executor& ex, std::shared_ptr<const file_info> info)
+    : info_(std::move(info))
+#ifdef HTTPLIB_FILE_READER_IO_URING
+    , file_(ex)
+#endif
+{
+#ifdef HTTPLIB_FILE_READER_IO_URING
+    // the descriptor is shared with the cache, the ring gets its own; on failure the pool reads.
+    int fd = ::dup(info_->file.native_handle());
+    if (fd != -1) {
+        boost::system::error_code ec;
+        file_.assign(fd, ec);
+        if (ec)
+            ::close(fd);
+    }
+#endif
+}
+
+net::awaitable<std::size_t> file_reader::async_read_some_at(std::uint64_t offset,
+                                                            net::mutable_buffer buffer,
+                                                            boost::system::error_code& ec)
+{
+#ifdef HTTPLIB_FILE_READER_IO_URING
+    if (file_.is_open()) {
+        auto bytes = co_await file_.async_read_some_at(offset, buffer, util::net_awaitable[ec]);
+        if (ec == net::error::eof)
+            ec = {};
+        co_return bytes;
+    }
+#endif
+#if defined(__linux__) && defined(RWF_NOWAIT)
+    if (std::size_t bytes = 0;
+        detail::read_cached(info_->file.native_handle(), offset, buffer, bytes, ec))
+        co_return bytes;
+#endif
+    co_return co_await net::co_spawn(
+        detail::blocking_pool(),
+        [&]() -> net::awaitable<std::size_t> {
+            co_return info_->read_at(offset, buffer.data(), buffer.size(), ec);
+        },
+        net::use_awaitable);
+}
+
+} // namespace httplib::server
@@ -0,0 +1,38 @@
+#pragma once
+#include "httplib/body/file_body.hpp"
+#include "httplib/config.hpp"
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
+#include <memory>
+
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_HAS_FILE)
+#define HTTPLIB_FILE_READER_IO_URING
+#include <boost/asio/random_access_file.hpp>
+#endif
+
+namespace httplib::server {
+
+// Positional reads of an open file that never block the calling thread: io_uring through
+// asio's random_access_file when asio is built with it (HTTPLIB_ENABLED_IO_URING), pread on a
+// small pool of threads kept for blocking file I/O otherwise.
+class file_reader
+{
+public:
+    using file_info = body::file_body::file_info;
+
+    file_reader(const net::any_io_executor& ex, std::shared_ptr<const file_info> info);
+
+    // reads at most buffer.size() bytes, 0 at the end of the file.
+    net::awaitable<std::size_t> async_read_some_at(std::uint64_t offset,
+                                                   net::mutable_buffer buffer,
+                                                   boost::system::error_code& ec);
+
+private:
+    std::shared_ptr<const file_info> info_;
+#ifdef HTTPLIB_FILE_READER_IO_URING
+    net::random_access_file file_;
+#endif
+};
+
+} // namespace httplib::server
@@ -0,0 +1,858 @@
+#ifdef HTTPLIB_ENABLED_HTTP2
+#include "http2_connection.hpp"
+#include "access_log.hpp"
+#include "compression.hpp"
+#include "httplib/util/use_awaitable.hpp"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core/string.hpp>
+#include <charconv>
+
+namespace httplib::server {
+
+namespace detail {
+
+static nghttp2_nv make_nv(beast::string_view name, beast::string_view value)
+{
+    return nghttp2_nv {reinterpret_cast<std::uint8_t*>(const_cast<char*>(name.data())),
+                       reinterpret_cast<std::uint8_t*>(const_cast<char*>(value.data())),
+                       name.size(),
+                       value.size(),
+                       NGHTTP2_NV_FLAG_NONE};
+}
+
+// connection specific headers are not allowed in HTTP/2.
+static bool is_connection_header(http::field name)
+{
+    switch (name) {
+        case http::field::connection:
+        case http::field::keep_alive:
+        case http::field::proxy_connection:
+        case http::field::transfer_encoding:
+        case http::field::upgrade: return true;
+        default: return false;
+    }
+}
+
+#if NGHTTP2_VERSION_NUM >= 0x013c00
+using data_provider = nghttp2_data_provider2;
+static constexpr auto session_mem_recv = &nghttp2_session_mem_recv2;
+static constexpr auto session_mem_send = &nghttp2_session_mem_send2;
+static constexpr auto submit_response  = &nghttp2_submit_response2;
+#else
+using data_provider = nghttp2_data_provider;
+static constexpr auto session_mem_recv = &nghttp2_session_mem_recv;
+static constexpr auto session_mem_send = &nghttp2_session_mem_send;
+static constexpr auto submit_response  = &nghttp2_submit_response;
+#endif
+
+} // namespace detail
+
+struct http2_connection::stream
+{
+    explicit stream(std::int32_t id)
+        : id(id)
+        , received_time(std::chrono::steady_clock::now())
+        , progress(received_time)
+    {
+    }
+
+    nghttp2_ssize read(std::uint8_t* buf, std::size_t length, std::uint32_t* data_flags);
+
+    std::int32_t id;
+    std::chrono::steady_clock::time_point received_time;
+    // the last time the stream moved: DATA came in, the handler asked for more, or response
+    // bytes went out. Whatever the client owes it is timed from here.
+    std::chrono::steady_clock::time_point progress;
+
+    http::request<body::any_body> header;
+    std::optional<body::any_body::reader> reader;
+
+    std::optional<response> resp;
+    std::optional<body::any_body::writer> writer;
+    net::const_buffer pending;
+    bool more      = true;
+    bool submitted = false;
+
+    // streamed bodies are produced into `out` by their own coroutine, `wakeup` parks it while
+    // nghttp2 has enough queued.
+    bool streamed = false;
+    bool eof      = false;
+    beast::flat_buffer out;
+    std::optional<net::steady_timer> wakeup;
+
+    // streamed request bodies (body_mode::streamed) queue their DATA in `in`, the flow control
+    // window only opens again as the handler reads. `wakeup` parks the handler meanwhile.
+    bool body_streamed = false;
+    bool body_done     = false;
+    bool body_wait     = false;
+    bool dispatched    = false;
+    bool handled       = false;
+    beast::flat_buffer in;
+
+    // matched when the header is in if a body follows, the request takes it over.
+    std::optional<request::route_match> route;
+
+    bool closed              = false;
+    std::uint64_t bytes_sent = 0;
+    std::optional<access_log::record> record;
+};
+
+nghttp2_ssize
+http2_connection::stream::read(std::uint8_t* buf, std::size_t length, std::uint32_t* data_flags)
+{
+    std::size_t copied = 0;
+    if (streamed) {
+        copied = net::buffer_copy(net::buffer(buf, length), out.data());
+        out.consume(copied);
+        if (wakeup)
+            wakeup->cancel();
+
+        if (out.size() == 0 && eof)
+            *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        else if (copied == 0)
+            return NGHTTP2_ERR_DEFERRED;
+
+        bytes_sent += copied;
+        progress = std::chrono::steady_clock::now();
+        return static_cast<nghttp2_ssize>(copied);
+    }
+
+    boost::system::error_code ec;
+    while (copied < length) {
+        if (pending.size() == 0) {
+            if (!more)
+                break;
+
+            auto result = writer->get(ec);
+            if (ec)
+                return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+            if (!result) {
+                more = false;
+                break;
+            }
+            pending = result->first;
+            more    = result->second;
+            continue;
+        }
+        auto bytes = net::buffer_copy(net::buffer(buf + copied, length - copied), pending);
+        pending += bytes;
+        copied += bytes;
+    }
+    if (!more && pending.size() == 0)
+        *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+
+    bytes_sent += copied;
+    if (copied != 0)
+        progress = std::chrono::steady_clock::now();
+    return static_cast<nghttp2_ssize>(copied);
+}
+
+class http2_connection::stream_body : public request::body_stream
+{
+public:
+    stream_body(std::shared_ptr<http2_connection> conn, std::shared_ptr<stream> strm)
+        : conn_(std::move(conn))
+        , strm_(std::move(strm))
+    {
+    }
+
+    net::awaitable<std::size_t> async_read_some(net::mutable_buffer buffer,
+                                                boost::system::error_code& ec) override
+    {
+        ec = {};
+        while (strm_->in.size() == 0 && !strm_->body_done) {
+            if (strm_->closed || conn_->closed_) {
+                ec = net::error::connection_reset;
+                co_return 0;
+            }
+            // the client owes the body from here on.
+            strm_->body_wait = true;
+            strm_->progress  = std::chrono::steady_clock::now();
+            conn_->update_deadline();
+            strm_->wakeup->expires_at(net::steady_timer::time_point::max());
+            co_await strm_->wakeup->async_wait(util::net_awaitable[ec]);
+            strm_->body_wait = false;
+            ec               = {};
+        }
+
+        auto bytes = net::buffer_copy(buffer, strm_->in.data());
+        strm_->in.consume(bytes);
+        if (bytes != 0 && !strm_->closed) {
+            nghttp2_session_consume(conn_->session_, strm_->id, bytes);
+            conn_->signal_write();
+        }
+        co_return bytes;
+    }
+    bool is_done() const override { return strm_->body_done && strm_->in.size() == 0; }
+
+private:
+    std::shared_ptr<http2_connection> conn_;
+    std::shared_ptr<stream> strm_;
+};
+
+http2_connection::http2_connection(http_server::impl& serv,
+                                   http_stream&& stream,
+                                   beast::flat_buffer&& buffer,
+                                   util::timer_wheel::entry& deadline)
+    : serv_(serv)
+    , stream_(std::move(stream))
+    , strand_(net::make_strand(stream_.get_executor()))
+    , deadline_(deadline)
+    , buffer_(std::move(buffer))
+    , write_signal_(strand_)
+{
+    boost::system::error_code ec;
+    local_endp_  = stream_.socket().local_endpoint(ec);
+    remote_endp_ = stream_.socket().remote_endpoint(ec);
+
+    nghttp2_session_callbacks* callbacks = nullptr;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, &on_begin_headers);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, &on_header);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, &on_data_chunk_recv);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, &on_frame_recv);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, &on_stream_close);
+    // DATA is acknowledged once consumed, so a streamed body is bounded by its window.
+    nghttp2_option* option = nullptr;
+    nghttp2_option_new(&option);
+    nghttp2_option_set_no_auto_window_update(option, 1);
+    nghttp2_session_server_new2(&session_, callbacks, this, option);
+    nghttp2_option_del(option);
+    nghttp2_session_callbacks_del(callbacks);
+}
+
+http2_connection::~http2_connection()
+{
+    nghttp2_session_del(session_);
+}
+
+bool http2_connection::upgrade(request&& req, std::string_view settings)
+{
+    auto head_request = req.method() == http::verb::head ? 1 : 0;
+    if (nghttp2_session_upgrade2(session_,
+                                 reinterpret_cast<const std::uint8_t*>(settings.data()),
+                                 settings.size(),
+                                 head_request,
+                                 nullptr) != 0)
+        return false;
+
+    auto strm    = std::make_shared<stream>(1);
+    strm->header = std::move(static_cast<http::request<body::any_body>&>(req));
+    streams_.emplace(strm->id, strm);
+    return true;
+}
+
+net::awaitable<void> http2_connection::run()
+{
+    co_await net::co_spawn(
+        strand_,
+        [this, self = shared_from_this()]() -> net::awaitable<void> {
+            // the default 64KiB windows stall uploads on any real latency.
+            static constexpr std::uint32_t stream_window_size     = 1024 * 1024;
+            static constexpr std::int32_t connection_window_size = 16 * 1024 * 1024;
+
+            nghttp2_settings_entry settings[] = {
+                {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, serv_.http2_max_concurrent_streams()},
+                {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, stream_window_size},
+            };
+            nghttp2_submit_settings(session_, NGHTTP2_FLAG_NONE, settings, std::size(settings));
+            nghttp2_session_set_local_window_size(
+                session_, NGHTTP2_FLAG_NONE, 0, connection_window_size);
+
+            // h2c upgrade: the request already arrived over HTTP/1.1.
+            if (auto strm = find_stream(1); strm)
+                on_request_done(strm);
+            update_deadline();
+
+            using namespace net::experimental::awaitable_operators;
+            co_await (read_loop() && write_loop());
+
+            closed_ = true;
+            stream_.close();
+            for (auto& [id, strm] : streams_) {
+                strm->closed = true;
+                if (strm->wakeup)
+                    strm->wakeup->cancel();
+            }
+        },
+        net::use_awaitable);
+}
+
+void http2_connection::close()
+{
+    net::post(strand_, [this, self = shared_from_this()]() {
+        closed_ = true;
+        stream_.close();
+        signal_write();
+    });
+}
+
+void http2_connection::drain()
+{
+    net::post(strand_, [this, self = shared_from_this()]() {
+        if (closed_ || goaway_)
+            return;
+
+        goaway_ = true;
+        nghttp2_submit_goaway(session_,
+                              NGHTTP2_FLAG_NONE,
+                              nghttp2_session_get_last_proc_stream_id(session_),
+                              NGHTTP2_NO_ERROR,
+                              nullptr,
+                              0);
+        signal_write();
+    });
+}
+
+net::awaitable<void> http2_connection::read_loop()
+{
+    boost::system::error_code ec;
+    for (;;) {
+        if (buffer_.size() != 0) {
+            auto data = buffer_.data();
+            auto rv   = detail::session_mem_recv(
+                session_, static_cast<const std::uint8_t*>(data.data()), data.size());
+            if (rv < 0) {
+                serv_.get_logger()->trace("http2 recv failed: {}", nghttp2_strerror(int(rv)));
+                break;
+            }
+            buffer_.consume(buffer_.size());
+            update_deadline();
+            signal_write();
+        }
+        if (closed_ || (!nghttp2_session_want_read(session_) &&
+                        !nghttp2_session_want_write(session_)))
+            break;
+
+        auto bytes = co_await stream_.async_read_some(buffer_.prepare(16 * 1024),
+                                                      util::net_awaitable[ec]);
+        if (ec) {
+            serv_.get_logger()->trace("http2 read failed: {}", ec.message());
+            break;
+        }
+        buffer_.commit(bytes);
+    }
+    closed_ = true;
+    signal_write();
+}
+
+net::awaitable<void> http2_connection::write_loop()
+{
+    static constexpr std::size_t max_write_size = 64 * 1024;
+
+    boost::system::error_code ec;
+    for (;;) {
+        // gather every pending frame into one write.
+        while (!closed_ && write_buffer_.size() < max_write_size) {
+            const std::uint8_t* data = nullptr;
+            auto bytes               = detail::session_mem_send(session_, &data);
+            if (bytes < 0) {
+                serv_.get_logger()->trace("http2 send failed: {}", nghttp2_strerror(int(bytes)));
+                closed_ = true;
+                break;
+            }
+            if (bytes == 0)
+                break;
+
+            write_buffer_.commit(net::buffer_copy(write_buffer_.prepare(bytes),
+                                                  net::buffer(data, bytes)));
+        }
+        if (write_buffer_.size() != 0 && !closed_) {
+            writing_ = true;
+            deadline_.expires_after(serv_.write_timeout());
+            co_await net::async_write(stream_, write_buffer_.data(), util::net_awaitable[ec]);
+            writing_ = false;
+            write_buffer_.consume(write_buffer_.size());
+            if (ec) {
+                serv_.get_logger()->trace("http2 write failed: {}", ec.message());
+                break;
+            }
+            update_deadline();
+            continue;
+        }
+        if (closed_ || (!nghttp2_session_want_read(session_) &&
+                        !nghttp2_session_want_write(session_)))
+            break;
+
+        // a response the client's window holds back starts its clock here.
+        update_deadline();
+        write_signal_.expires_at(net::steady_timer::time_point::max());
+        co_await write_signal_.async_wait(util::net_awaitable[ec]);
+    }
+    // unblocks the read loop.
+    closed_ = true;
+    stream_.close();
+}
+
+net::awaitable<void> http2_connection::handle_request(std::shared_ptr<stream> strm)
+{
+    auto& router = serv_.router();
+    detail::in_flight_scope in_flight(serv_);
+
+    request req(local_endp_, remote_endp_, std::move(strm->header));
+    if (strm->route)
+        req.set_route(std::move(*strm->route));
+    auto& resp = strm->resp.emplace(req.version(), true);
+    if (strm->body_streamed)
+        req.set_body_stream(std::make_unique<stream_body>(shared_from_this(), strm));
+
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+        if (co_await router.pre_routing(req, resp))
+            co_await router.proc_routing(req, resp);
+        co_await router.post_routing(req, resp);
+    }
+    catch (const std::exception& e) {
+        serv_.get_logger()->warn("exception in business function, reason: {}", e.what());
+        resp.set_string_content(
+            std::string(e.what()), "text/plain", http::status::internal_server_error);
+    }
+    catch (...) {
+        serv_.get_logger()->warn("unknown exception in business function");
+        resp.set_string_content(
+            std::string("unknown exception"), "text/plain", http::status::internal_server_error);
+    }
+    auto span_time = std::chrono::steady_clock::now() - start_time;
+
+    // what the handler left of a streamed body, and whatever still comes, is dropped.
+    if (strm->body_streamed) {
+        strm->body_streamed = false;
+        if (strm->in.size() != 0 && !strm->closed)
+            nghttp2_session_consume(session_, strm->id, strm->in.size());
+        strm->in.clear();
+    }
+
+    serv_.get_logger()->debug(
+        "{} {} (h2 {}:{}) {} {}ms",
+        req.method_string(),
+        req.target(),
+        remote_endp_.address().to_string(),
+        remote_endp_.port(),
+        resp.result_int(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(span_time).count());
+
+    if (serv_.get_access_log()) {
+        using namespace std::chrono;
+        auto& rec   = strm->record.emplace();
+        rec.time_us = duration_cast<microseconds>(
+                          (system_clock::now() - (steady_clock::now() - strm->received_time))
+                              .time_since_epoch())
+                          .count();
+        rec.handler_us = static_cast<std::uint32_t>(duration_cast<microseconds>(span_time).count());
+        rec.status     = static_cast<std::uint16_t>(resp.result_int());
+        rec.local_port = local_endp_.port();
+        rec.version    = 20;
+        rec.method     = req.method();
+        rec.set_remote(remote_endp_);
+        rec.set_target({req.target().data(), req.target().size()});
+    }
+
+    if (!resp.stream_handler_) {
+        if (!resp.has_content_length())
+            resp.prepare_payload();
+
+        const auto& policy = resp.compression_policy_ ? *resp.compression_policy_
+                                                      : serv_.get_compression_policy();
+        if (co_await async_apply_compression(policy, req, resp) == compression_mode::streamed)
+            resp.erase(http::field::content_length);
+    }
+    if (!strm->closed && !closed_) {
+        submit_response(*strm, req);
+        if (strm->streamed)
+            co_await produce_stream_body(strm);
+    }
+    // a client that has not ended its side yet is waited for from now.
+    strm->handled  = true;
+    strm->progress = std::chrono::steady_clock::now();
+    update_deadline();
+}
+
+net::awaitable<void> http2_connection::produce_stream_body(std::shared_ptr<stream> strm)
+{
+    static constexpr std::size_t high_water = 256 * 1024;
+
+    auto& resp = *strm->resp;
+    strm->wakeup.emplace(strand_);
+
+    beast::flat_buffer chunk;
+    boost::system::error_code ec;
+    try {
+        for (;;) {
+            ec            = {};
+            bool has_more = co_await resp.stream_handler_(chunk, ec);
+            if (strm->closed || closed_)
+                break;
+            if (ec) {
+                serv_.get_logger()->trace("read chunk body failed: {}", ec.message());
+                nghttp2_submit_rst_stream(
+                    session_, NGHTTP2_FLAG_NONE, strm->id, NGHTTP2_INTERNAL_ERROR);
+                signal_write();
+                break;
+            }
+            strm->out.commit(net::buffer_copy(strm->out.prepare(chunk.size()), chunk.data()));
+            chunk.consume(chunk.size());
+
+            strm->eof = !has_more;
+            nghttp2_session_resume_data(session_, strm->id);
+            signal_write();
+            if (strm->eof)
+                break;
+
+            while (strm->out.size() > high_water && !strm->closed && !closed_) {
+                strm->wakeup->expires_at(net::steady_timer::time_point::max());
+                co_await strm->wakeup->async_wait(util::net_awaitable[ec]);
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        serv_.get_logger()->warn("exception in stream content, reason: {}", e.what());
+        if (!strm->closed && !closed_) {
+            nghttp2_submit_rst_stream(
+                session_, NGHTTP2_FLAG_NONE, strm->id, NGHTTP2_INTERNAL_ERROR);
+            signal_write();
+        }
+    }
+}
+
+void http2_connection::submit_response(stream& strm, const request& req)
+{
+    auto& resp = *strm.resp;
+    // the content was prepared and compressed by handle_request.
+    if (resp.stream_handler_)
+        strm.streamed = true;
+    if (req.method() == http::verb::head)
+        resp.reset_content();
+
+    if (!strm.streamed) {
+        boost::system::error_code ec;
+        strm.writer.emplace(resp, resp.body());
+        strm.writer->init(ec);
+        if (ec) {
+            nghttp2_submit_rst_stream(session_, NGHTTP2_FLAG_NONE, strm.id, NGHTTP2_INTERNAL_ERROR);
+            signal_write();
+            return;
+        }
+    }
+
+    // HTTP/2 wants lower case names, build them first so the views stay valid.
+    auto status = std::to_string(resp.result_int());
+    std::vector<std::string> names;
+    for (const auto& field : resp) {
+        if (detail::is_connection_header(field.name()))
+            continue;
+        auto name = std::string(field.name_string().data(), field.name_string().size());
+        for (auto& c : name)
+            c = beast::ascii_tolower(c);
+        names.push_back(std::move(name));
+    }
+
+    std::vector<nghttp2_nv> nva;
+    nva.reserve(names.size() + 1);
+    nva.push_back(detail::make_nv(":status", status));
+
+    auto name = names.begin();
+    for (const auto& field : resp) {
+        if (detail::is_connection_header(field.name()))
+            continue;
+        nva.push_back(detail::make_nv(*name++, field.value()));
+    }
+
+    detail::data_provider provider;
+    provider.source.ptr    = &strm;
+    provider.read_callback = &http2_connection::read_body;
+
+    if (auto rv =
+            detail::submit_response(session_, strm.id, nva.data(), nva.size(), &provider);
+        rv != 0)
+        serv_.get_logger()->trace("http2 submit response failed: {}", nghttp2_strerror(rv));
+    strm.submitted = true;
+    strm.progress  = std::chrono::steady_clock::now();
+    signal_write();
+}
+
+void http2_connection::signal_write()
+{
+    write_signal_.cancel();
+}
+
+void http2_connection::update_deadline()
+{
+    // a write in progress keeps its own deadline.
+    if (writing_)
+        return;
+    if (streams_.empty()) {
+        deadline_.expires_after(serv_.keep_alive_timeout());
+        return;
+    }
+
+    // the stream the client has kept waiting the longest bounds the connection.
+    std::optional<std::chrono::steady_clock::time_point> expiry;
+    for (const auto& [id, strm] : streams_) {
+        if (auto at = stream_deadline(*strm); at && (!expiry || *at < *expiry))
+            expiry = at;
+    }
+    if (expiry)
+        deadline_.expires_at(*expiry);
+    else
+        deadline_.expires_never();
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+http2_connection::stream_deadline(const stream& strm) const
+{
+    // a response held back by the client's flow control window.
+    bool unsent = strm.streamed ? strm.out.size() != 0 : strm.more || strm.pending.size() != 0;
+    if (strm.submitted && unsent &&
+        (nghttp2_session_get_stream_remote_window_size(session_, strm.id) <= 0 ||
+         nghttp2_session_get_remote_window_size(session_) <= 0))
+        return strm.progress + serv_.write_timeout();
+
+    // the request, or the rest of its body, has not arrived; a handler at work has no deadline.
+    bool handling = strm.dispatched && !strm.handled && !strm.body_wait;
+    if (!strm.body_done && !handling)
+        return strm.progress + serv_.read_timeout();
+    return std::nullopt;
+}
+
+std::shared_ptr<http2_connection::stream> http2_connection::find_stream(std::int32_t stream_id)
+{
+    auto iter = streams_.find(stream_id);
+    if (iter == streams_.end())
+        return nullptr;
+    return iter->second;
+}
+
+request::route_match http2_connection::match_route(const stream& strm) const
+{
+    auto target = std::string_view(strm.header.target().data(), strm.header.target().size());
+    auto path   = target.substr(0, target.find('?'));
+
+    std::string decoded;
+    if (path.find('%') != std::string_view::npos) {
+        decoded = util::url_decode(path);
+        path    = decoded;
+    }
+    return serv_.router().match(strm.header.method(), path);
+}
+
+void http2_connection::on_request_done(std::shared_ptr<stream> strm)
+{
+    strm->dispatched = true;
+    if (strm->reader) {
+        boost::system::error_code ec;
+        strm->reader->finish(ec);
+        strm->reader.reset();
+        if (ec) {
+            nghttp2_submit_rst_stream(
+                session_, NGHTTP2_FLAG_NONE, strm->id, NGHTTP2_PROTOCOL_ERROR);
+            return;
+        }
+    }
+    net::co_spawn(
+        strand_,
+        [this, self = shared_from_this(), strm]() -> net::awaitable<void> {
+            try {
+                co_await handle_request(strm);
+            }
+            catch (const std::exception& e) {
+                // past the handler: compressing or submitting the response failed.
+                serv_.get_logger()->warn("exception in http2 response, reason: {}", e.what());
+                if (!strm->closed && !closed_) {
+                    nghttp2_submit_rst_stream(
+                        session_, NGHTTP2_FLAG_NONE, strm->id, NGHTTP2_INTERNAL_ERROR);
+                    signal_write();
+                }
+            }
+        },
+        net::detached);
+}
+
+int http2_connection::on_begin_headers(nghttp2_session*, const nghttp2_frame* frame, void* ptr)
+{
+    auto& self = *static_cast<http2_connection*>(ptr);
+    if (frame->hd.type != NGHTTP2_HEADERS || frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        return 0;
+
+    self.streams_.emplace(frame->hd.stream_id, std::make_shared<stream>(frame->hd.stream_id));
+    self.update_deadline();
+
+    if (self.serv_.draining() && !self.goaway_) {
+        self.goaway_ = true;
+        nghttp2_submit_goaway(
+            self.session_, NGHTTP2_FLAG_NONE, frame->hd.stream_id, NGHTTP2_NO_ERROR, nullptr, 0);
+    }
+    return 0;
+}
+
+int http2_connection::on_header(nghttp2_session*,
+                                const nghttp2_frame* frame,
+                                const std::uint8_t* name,
+                                std::size_t namelen,
+                                const std::uint8_t* value,
+                                std::size_t valuelen,
+                                std::uint8_t,
+                                void* ptr)
+{
+    auto& self = *static_cast<http2_connection*>(ptr);
+    if (frame->hd.type != NGHTTP2_HEADERS || frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+        return 0;
+
+    auto strm = self.find_stream(frame->hd.stream_id);
+    if (!strm)
+        return 0;
+
+    auto key = beast::string_view(reinterpret_cast<const char*>(name), namelen);
+    auto val = beast::string_view(reinterpret_cast<const char*>(value), valuelen);
+    auto& header = strm->header;
+    if (key == ":method")
+        header.method_string(val);
+    else if (key == ":path")
+        header.target(val);
+    else if (key == ":authority")
+        header.set(http::field::host, val);
+    else if (key.starts_with(':'))
+        return 0;
+    else if (auto iter = header.find(http::field::cookie); key == "cookie" && iter != header.end())
+        // split cookie crumbs are joined back the HTTP/1.1 way.
+        header.set(http::field::cookie,
+                   std::string(iter->value().data(), iter->value().size()) + "; " +
+                       std::string(val.data(), val.size()));
+    else
+        header.insert(key, val);
+    return 0;
+}
+
+int http2_connection::on_data_chunk_recv(nghttp2_session* session,
+                                         std::uint8_t,
+                                         std::int32_t stream_id,
+                                         const std::uint8_t* data,
+                                         std::size_t len,
+                                         void* ptr)
+{
+    auto& self = *static_cast<http2_connection*>(ptr);
+    auto strm  = self.find_stream(stream_id);
+    if (strm)
+        strm->progress = std::chrono::steady_clock::now();
+    if (strm && strm->body_streamed) {
+        strm->in.commit(net::buffer_copy(strm->in.prepare(len), net::buffer(data, len)));
+        strm->wakeup->cancel();
+        return 0;
+    }
+    nghttp2_session_consume(session, stream_id, len);
+    if (!strm || !strm->reader)
+        return 0;
+
+    boost::system::error_code ec;
+    strm->reader->put(net::buffer(data, len), ec);
+    if (ec)
+        nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, stream_id, NGHTTP2_INTERNAL_ERROR);
+    return 0;
+}
+
+int http2_connection::on_frame_recv(nghttp2_session*, const nghttp2_frame* frame, void* ptr)
+{
+    auto& self = *static_cast<http2_connection*>(ptr);
+    if (frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA)
+        return 0;
+
+    auto strm = self.find_stream(frame->hd.stream_id);
+    if (!strm)
+        return 0;
+
+    bool end_stream = (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) != 0;
+    if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST &&
+        !end_stream)
+    {
+        strm->route = self.match_route(*strm);
+        auto mode   = router_impl::query_body_mode(*strm->route);
+        if (mode == body_mode::streamed) {
+            // the handler starts now and reads the body while it arrives.
+            strm->body_streamed = true;
+            strm->wakeup.emplace(self.strand_);
+            self.on_request_done(strm);
+            return 0;
+        }
+        self.serv_.prepare_body(mode, strm->header);
+
+        boost::optional<std::uint64_t> content_length;
+        if (auto iter = strm->header.find(http::field::content_length);
+            iter != strm->header.end())
+        {
+            std::uint64_t length = 0;
+            auto value           = iter->value();
+            auto [p, err] = std::from_chars(value.data(), value.data() + value.size(), length);
+            if (err == std::errc {})
+                content_length = length;
+        }
+
+        boost::system::error_code ec;
+        strm->reader.emplace(strm->header, strm->header.body());
+        strm->reader->init(content_length, ec);
+        if (ec) {
+            strm->reader.reset();
+            nghttp2_submit_rst_stream(
+                self.session_, NGHTTP2_FLAG_NONE, strm->id, NGHTTP2_INTERNAL_ERROR);
+            return 0;
+        }
+    }
+    if (end_stream) {
+        strm->body_done = true;
+        if (strm->wakeup)
+            strm->wakeup->cancel();
+        if (!strm->dispatched)
+            self.on_request_done(strm);
+    }
+    return 0;
+}
+
+int http2_connection::on_stream_close(nghttp2_session*,
+                                      std::int32_t stream_id,
+                                      std::uint32_t,
+                                      void* ptr)
+{
+    auto& self = *static_cast<http2_connection*>(ptr);
+    auto strm  = self.find_stream(stream_id);
+    if (!strm)
+        return 0;
+
+    strm->closed = true;
+    if (strm->wakeup)
+        strm->wakeup->cancel();
+    // unread DATA still counts against the connection window.
+    if (strm->body_streamed && strm->in.size() != 0) {
+        nghttp2_session_consume_connection(self.session_, strm->in.size());
+        strm->in.clear();
+    }
+
+    if (auto* log = self.serv_.get_access_log(); log && strm->record) {
+        auto& rec       = *strm->record;
+        rec.duration_us = static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - strm->received_time)
+                .count());
+        rec.bytes_sent = strm->bytes_sent;
+        log->push(rec);
+    }
+
+    self.streams_.erase(stream_id);
+    self.update_deadline();
+    return 0;
+}
+
+nghttp2_ssize http2_connection::read_body(nghttp2_session*,
+                                          std::int32_t,
+                                          std::uint8_t* buf,
+                                          std::size_t length,
+                                          std::uint32_t* data_flags,
+                                          nghttp2_data_source* source,
+                                          void*)
+{
+    return static_cast<stream*>(source->ptr)->read(buf, length, data_flags);
+}
+
+} // namespace httplib::server
+#endif
@@ -0,0 +1,114 @@
+#pragma once
+#ifdef HTTPLIB_ENABLED_HTTP2
+#include "httplib/server/request.hpp"
+#include "httplib/server/response.hpp"
+#include "server_impl.h"
+#include "stream/http_stream.hpp"
+#include "util/timer_wheel.hpp"
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core/flat_buffer.hpp>
+#include <map>
+#include <memory>
+#include <nghttp2/nghttp2.h>
+#include <optional>
+
+namespace httplib::server {
+
+#if NGHTTP2_VERSION_NUM < 0x013c00
+// nghttp2 before 1.60 has only the ssize_t callbacks.
+using nghttp2_ssize = ssize_t;
+#endif
+
+// One HTTP/2 connection. nghttp2 does the framing, HPACK and flow control; every stream is
+// dispatched through the router on its own coroutine. All of it runs on one strand, the
+// handlers included, so the nghttp2 session is never touched concurrently.
+class http2_connection : public std::enable_shared_from_this<http2_connection>
+{
+public:
+    // `buffer` holds what was already read from the connection, the client preface included.
+    http2_connection(http_server::impl& serv,
+                     http_stream&& stream,
+                     beast::flat_buffer&& buffer,
+                     util::timer_wheel::entry& deadline);
+    ~http2_connection();
+
+    // h2c upgrade: the HTTP/1.1 request becomes stream 1, `settings` is the decoded
+    // HTTP2-Settings header. Must be called before run().
+    bool upgrade(request&& req, std::string_view settings);
+
+    net::awaitable<void> run();
+
+    void close();
+    // GOAWAY: no new streams, the open ones are completed.
+    void drain();
+
+private:
+    struct stream;
+    class stream_body;
+
+    net::awaitable<void> read_loop();
+    net::awaitable<void> write_loop();
+    net::awaitable<void> handle_request(std::shared_ptr<stream> strm);
+    net::awaitable<void> produce_stream_body(std::shared_ptr<stream> strm);
+
+    void submit_response(stream& strm, const request& req);
+    void signal_write();
+    void update_deadline();
+    std::optional<std::chrono::steady_clock::time_point> stream_deadline(const stream& strm) const;
+
+    std::shared_ptr<stream> find_stream(std::int32_t stream_id);
+    request::route_match match_route(const stream& strm) const;
+    void on_request_done(std::shared_ptr<stream> strm);
+
+    static int on_begin_headers(nghttp2_session* session, const nghttp2_frame* frame, void* ptr);
+    static int on_header(nghttp2_session* session,
+                         const nghttp2_frame* frame,
+                         const std::uint8_t* name,
+                         std::size_t namelen,
+                         const std::uint8_t* value,
+                         std::size_t valuelen,
+                         std::uint8_t flags,
+                         void* ptr);
+    static int on_data_chunk_recv(nghttp2_session* session,
+                                  std::uint8_t flags,
+                                  std::int32_t stream_id,
+                                  const std::uint8_t* data,
+                                  std::size_t len,
+                                  void* ptr);
+    static int on_frame_recv(nghttp2_session* session, const nghttp2_frame* frame, void* ptr);
+    static int on_stream_close(nghttp2_session* session,
+                               std::int32_t stream_id,
+                               std::uint32_t error_code,
+                               void* ptr);
+    static nghttp2_ssize read_body(nghttp2_session* session,
+                                   std::int32_t stream_id,
+                                   std::uint8_t* buf,
+                                   std::size_t length,
+                                   std::uint32_t* data_flags,
+                                   nghttp2_data_source* source,
+                                   void* ptr);
+
+private:
+    http_server::impl& serv_;
+    http_stream stream_;
+    net::strand<net::any_io_executor> strand_;
+    util::timer_wheel::entry& deadline_;
+
+    tcp::endpoint local_endp_;
+    tcp::endpoint remote_endp_;
+
+    nghttp2_session* session_ = nullptr;
+    std::map<std::int32_t, std::shared_ptr<stream>> streams_;
+
+    beast::flat_buffer buffer_;
+    beast::flat_buffer write_buffer_;
+    net::steady_timer write_signal_;
+
+    bool writing_ = false;
+    bool closed_  = false;
+    bool goaway_  = false;
+};
+
+} // namespace httplib::server
+#endif
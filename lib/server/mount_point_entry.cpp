@@ -1,5 +1,7 @@
 #include "httplib/server/mount_point_entry.hpp"
+#include "file_cache.hpp"
 #include "html/html.h"
+#include "httplib/html/accept_content.hpp"
 #include "httplib/server/request.hpp"
 #include "httplib/server/response.hpp"
 
@@ -60,6 +62,7 @@ mount_point_entry::mount_point_entry(const std::string& mount_point, const fs::p
     : mount_point_(mount_point)
     , base_dir_(base_dir)
 {
+    reset_file_cache();
 }
 const std::string& mount_point_entry::mount_point() const
 {
@@ -80,6 +83,25 @@ void mount_point_entry::operator()(request& req, response& res) const
     std::error_code ec;
     auto path = base_dir_ / fs::path(std::u8string_view((const char8_t*)relative_path.data(),
                                                         relative_path.size()));
+    // a cached hit makes no file system call at all.
+    if (file_cache_) {
+        if (path.has_filename()) {
+            if (auto info = file_cache_->get(path); info) {
+                send_file(path, std::move(info), req, res);
+                return;
+            }
+        }
+        else {
+            for (const auto& doc_name : default_doc_name_) {
+                auto doc_path = path / doc_name;
+                if (auto info = file_cache_->get(doc_path); info) {
+                    send_file(doc_path, std::move(info), req, res);
+                    return;
+                }
+            }
+        }
+    }
+
     if (!fs::exists(path, ec)) {
         res.set_error_content(http::status::not_found);
         return;
@@ -99,7 +121,7 @@ void mount_point_entry::operator()(request& req, response& res) const
     }
     if (path.has_filename()) {
         if (fs::is_regular_file(path, ec))
-            res.set_file_content(path, req.base());
+            send_file(path, nullptr, req, res);
         else
             res.set_error_content(http::status::not_found);
         return;
@@ -129,6 +151,51 @@ void mount_point_entry::operator()(request& req, response& res) const
     res.set_error_content(http::status::forbidden);
 }
 
+void mount_point_entry::send_file(const fs::path& path,
+                                  std::shared_ptr<const body::file_body::file_info> info,
+                                  request& req,
+                                  response& res) const
+{
+    static constexpr std::pair<std::string_view, std::string_view> variants[] = {
+        {"br", ".br"}, {"zstd", ".zst"}, {"gzip", ".gz"}};
+
+    auto open = [this](const fs::path& file_path,
+                       std::string_view content_encoding) -> file_cache::file_info_ptr {
+        if (file_cache_)
+            return file_cache_->get(file_path, content_encoding);
+        boost::system::error_code ec;
+        return body::file_body::file_info::open(file_path, ec, content_encoding);
+    };
+
+    if (precompressed_) {
+        if (auto iter = req.find(http::field::accept_encoding); iter != req.end()) {
+            html::accept_encoding_content accept;
+            accept.parse({iter->value().data(), iter->value().size()});
+            for (const auto& [encoding, extension] : variants) {
+                if (!accept.accepts(encoding))
+                    continue;
+                auto variant_path = path;
+                variant_path += extension;
+                if (auto variant = open(variant_path, encoding); variant) {
+                    res.set_file_content(std::move(variant), req.base());
+                    return;
+                }
+            }
+        }
+    }
+
+    if (!info)
+        info = open(path, {});
+    if (!info) {
+        res.set_error_content(http::status::not_found);
+        return;
+    }
+    res.set_file_content(std::move(info), req.base());
+    // the response would have been a precompressed one for another client.
+    if (precompressed_)
+        res.set(http::field::vary, "Accept-Encoding");
+}
+
 void mount_point_entry::set_enabled_dir(bool enabled)
 {
     enabled_dir_ = enabled;
@@ -144,4 +211,34 @@ void mount_point_entry::set_default_doc_name(const std::vector<std::string>& def
     default_doc_name_ = default_doc_name;
 }
 
+void mount_point_entry::set_precompressed(bool enabled)
+{
+    precompressed_ = enabled;
+}
+
+void mount_point_entry::set_file_cache(std::size_t max_files,
+                                       const std::chrono::steady_clock::duration& ttl)
+{
+    file_cache_size_ = max_files;
+    file_cache_ttl_  = ttl;
+    reset_file_cache();
+}
+
+void mount_point_entry::set_memory_cache(std::size_t max_bytes, std::size_t max_file_size)
+{
+    memory_cache_size_      = max_bytes;
+    memory_cache_file_size_ = max_file_size;
+    reset_file_cache();
+}
+
+void mount_point_entry::reset_file_cache()
+{
+    if (file_cache_size_ == 0) {
+        file_cache_.reset();
+        return;
+    }
+    file_cache_ = std::make_shared<file_cache>(
+        file_cache_size_, file_cache_ttl_, memory_cache_size_, memory_cache_file_size_);
+}
+
 } // namespace httplib::server
@@ -11,18 +11,17 @@ request::request(const tcp::endpoint& local_endpoint,
     , local_endpoint_(local_endpoint)
     , remote_endpoint_(remote_endpoint)
 {
-    if (auto pos = this->target().find("?"); pos == std::string_view::npos) {
-        this->decoded_path_ = util::url_decode(this->target());
-    }
-    else {
-        this->decoded_path_ = util::url_decode(this->target().substr(0, pos));
-        this->query_params_.decode(this->target().substr(pos + 1));
-    }
+    auto raw_path = std::string_view(this->target());
+    raw_path      = raw_path.substr(0, raw_path.find('?'));
+    if (raw_path.find('%') != std::string_view::npos)
+        this->decoded_path_ = util::url_decode(raw_path);
 }
 request::request(const tcp::endpoint& local_endpoint,
                  const tcp::endpoint& remote_endpoint,
                  http::request<http::empty_body>&& other)
-    : request(local_endpoint, remote_endpoint, http::request<body::any_body>(other))
+    : request(local_endpoint,
+              remote_endpoint,
+              http::request<body::any_body>(std::move(other.base())))
 {
 }
 request& request::operator=(request&& other) noexcept
@@ -37,6 +36,8 @@ request& request::operator=(request&& other) noexcept
     remote_endpoint_ = std::move(other.remote_endpoint_);
     path_params_     = std::move(other.path_params_);
     custom_data_     = std::move(other.custom_data_);
+    body_stream_     = std::move(other.body_stream_);
+    route_           = std::move(other.route_);
     return *this;
 }
 request::request(request&& other) noexcept
@@ -50,10 +51,11 @@ request::~request()
 
 std::string_view request::path() const
 {
-    if (this->decoded_path_.empty())
-        return std::string_view(this->target());
+    if (!this->decoded_path_.empty())
+        return this->decoded_path_;
 
-    return this->decoded_path_;
+    auto target = std::string_view(this->target());
+    return target.substr(0, target.find('?'));
 }
 
 httplib::net::ip::address request::get_client_ip() const
@@ -90,21 +92,70 @@ void request::set_custom_data(std::any&& data)
 
 std::string_view request::path_param(const std::string& key) const
 {
-    return path_params_.at(key);
+    for (const auto& v : path_params_) {
+        if (v.first == key)
+            return v.second;
+    }
+    throw std::out_of_range("no path param: " + key);
 }
 
 void request::add_path_param(const std::string& key, const std::string& val)
 {
-    path_params_[key] = val;
+    for (auto& v : path_params_) {
+        if (v.first == key) {
+            v.second = val;
+            return;
+        }
+    }
+    path_params_.emplace_back(key, val);
 }
 void request::set_path_param(std::unordered_map<std::string, std::string>&& params)
 {
-    path_params_ = std::move(params);
+    path_params_.clear();
+    path_params_.reserve(params.size());
+    for (auto& v : params)
+        path_params_.emplace_back(v.first, std::move(v.second));
+}
+
+net::awaitable<std::size_t> request::async_read_some(net::mutable_buffer buffer,
+                                                     boost::system::error_code& ec)
+{
+    ec = {};
+    if (!body_stream_)
+        co_return 0;
+    co_return co_await body_stream_->async_read_some(buffer, ec);
+}
+
+bool request::is_body_done() const
+{
+    return !body_stream_ || body_stream_->is_done();
+}
+
+void request::set_body_stream(std::unique_ptr<body_stream>&& stream)
+{
+    body_stream_ = std::move(stream);
+}
+
+const request::route_match* request::route() const
+{
+    return route_ ? &*route_ : nullptr;
+}
+
+void request::set_route(route_match&& match)
+{
+    path_params_ = std::move(match.params);
+    route_       = std::move(match);
 }
 
 const html::query_params& request::query_params() const
 {
-    return query_params_;
+    if (!query_params_) {
+        query_params_.emplace();
+        auto target = std::string_view(this->target());
+        if (auto pos = target.find('?'); pos != std::string_view::npos)
+            query_params_->decode(target.substr(pos + 1));
+    }
+    return *query_params_;
 }
 
 } // namespace httplib::server
\ No newline at end of file
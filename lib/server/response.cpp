@@ -1,6 +1,5 @@
 #include "httplib/server/response.hpp"
 #include "html/html.h"
-#include "mime_types.hpp"
 #include <boost/beast/version.hpp>
 #include <fmt/format.h>
 
@@ -78,13 +77,22 @@ void response::set_json_content(boost::json::value&& data,
 void response::set_file_content(const fs::path& path, const http::fields& req_header /*= {}*/)
 {
     reset_content();
-    std::error_code ec;
-    auto file_size = fs::file_size(path, ec);
+    boost::system::error_code ec;
+    auto info = body::file_body::file_info::open(path, ec);
     if (ec)
         return;
-    auto file_write_time = html::file_last_write_time(path, ec);
-    if (ec)
+    set_file_content(std::move(info), req_header);
+}
+
+void response::set_file_content(std::shared_ptr<const body::file_body::file_info> info,
+                                const http::fields& req_header /*= {}*/)
+{
+    reset_content();
+    if (!info) {
+        set_error_content(http::status::not_found);
         return;
+    }
+    auto file_size = info->size;
 
     html::http_ranges ranges;
     if (!ranges.parse(req_header[http::field::range], file_size)) {
@@ -93,28 +101,27 @@ void response::set_file_content(const fs::path& path, const http::fields& req_he
         return;
     }
     // etag
-    auto file_etag_str = fmt::format("W/{}-{}", file_size, file_write_time);
-    if (req_header[http::field::if_none_match] == file_etag_str) {
+    if (req_header[http::field::if_none_match] == info->etag) {
         set_empty_content(http::status::not_modified);
         return;
     }
     // last modified
-    auto file_gmt_date_str = html::format_http_gmt_date(file_write_time);
-    if (req_header[http::field::if_modified_since] == file_gmt_date_str) {
+    if (req_header[http::field::if_modified_since] == info->last_modified) {
         set_empty_content(http::status::not_modified);
         return;
     }
 
     body::file_body::value_type file;
-    file.open(path, std::ios::in | std::ios::binary);
-    if (!file.is_open())
-        return;
-
-    file.content_type = mime::get_mime_type(path.extension().string());
+    file.content_type = info->content_type;
     file.ranges       = std::move(ranges);
 
-    this->set(http::field::etag, file_etag_str);
-    this->set(http::field::last_modified, file_gmt_date_str);
+    this->set(http::field::etag, info->etag);
+    this->set(http::field::last_modified, info->last_modified);
+    if (!info->content_encoding.empty()) {
+        this->set(http::field::content_encoding, info->content_encoding);
+        this->set(http::field::vary, "Accept-Encoding");
+    }
+    file.info = std::move(info);
 
     if (file.ranges.empty()) {
         this->set(http::field::accept_ranges, "bytes");
@@ -1,24 +1,56 @@
 #include "router_impl.h"
+#include <algorithm>
 #include <boost/algorithm/string/join.hpp>
-#include <iostream>
+#include <boost/algorithm/string/trim.hpp>
 #include <set>
 
 namespace httplib::server {
 
 namespace detail {
 
-static auto split_segments(std::string_view path)
+// util::split(path, "/") without the allocation, plus an empty last segment for a trailing
+// slash. Segments point into `path`, the trailing one at its end.
+template<typename Segments>
+static Segments split_segments(std::string_view path)
 {
-    auto segments = util::split(path, "/");
+    Segments segments;
+    std::size_t pos = 0;
+    while (!path.empty()) {
+        auto found = path.find('/', pos);
+        if (found == 0) {
+            pos = 1;
+            continue;
+        }
+        segments.push_back(boost::trim_copy(path.substr(pos, found - pos)));
+        if (found == std::string_view::npos || found + 1 >= path.size())
+            break;
+        pos = found + 1;
+    }
 
     if (path.ends_with("/"))
-        segments.push_back(std::string_view());
+        segments.push_back(path.substr(path.size()));
 
     return segments;
 }
 
-} // namespace detail
+static constexpr std::uint64_t method_bit(http::verb method)
+{
+    return std::uint64_t(1) << static_cast<unsigned>(method);
+}
+static_assert(static_cast<unsigned>(http::verb::unlink) < 64, "http::verb no longer fits a mask");
 
+static std::string join_methods(std::uint64_t methods)
+{
+    // sorted by name, like the Allow headers always were.
+    std::set<std::string> names;
+    for (unsigned i = 0; i < 64; ++i) {
+        if (methods & (std::uint64_t(1) << i))
+            names.insert(to_string(static_cast<http::verb>(i)));
+    }
+    return boost::join(names, ",");
+}
+
+} // namespace detail
 router_impl::router_impl()
     : root_(std::make_unique<Node>())
 {
@@ -26,18 +58,154 @@ router_impl::router_impl()
 
 void router_impl::set_http_handler_impl(http::verb method,
                                         std::string_view path,
-                                        coro_http_handler_type&& handler)
+                                        coro_http_handler_type&& handler,
+                                        body_mode mode,
+                                        bool may_suspend)
 {
-    // std::unique_lock lock(mutex_);
-    auto segments          = detail::split_segments(path);
+    std::lock_guard lock(mutex_);
+    auto segments          = detail::split_segments<segments_type>(path);
     auto node              = insert(root_.get(), segments, 0);
-    node->handlers[method] = std::move(handler);
+    node->handlers[method] = std::make_shared<const route_entry>(
+        route_entry {std::move(handler), mode, may_suspend});
+    route_changed();
+}
+
+void router_impl::remove_http_handler_impl(http::verb method, std::string_view path)
+{
+    std::lock_guard lock(mutex_);
+    auto segments = detail::split_segments<segments_type>(path);
+    insert(root_.get(), segments, 0)->handlers.erase(method);
+    prune(*root_);
+    route_changed();
+}
+
+void router_impl::update_impl(const std::function<void()>& changes)
+{
+    std::lock_guard lock(mutex_);
+    ++batch_;
+    try {
+        changes();
+    }
+    catch (...) {
+        // what was changed before the throw is published all the same.
+        --batch_;
+        route_changed();
+        throw;
+    }
+    --batch_;
+    route_changed();
+}
+
+void router_impl::freeze()
+{
+    std::lock_guard lock(mutex_);
+    frozen_ = true;
+    publish();
+}
+
+void router_impl::route_changed()
+{
+    // changes made once serving started take effect right away, a batch when it ends.
+    if (frozen_ && batch_ == 0)
+        publish();
+}
+
+void router_impl::publish()
+{
+    // built from a copy, the tree keeps taking changes while requests match the old snapshot.
+    auto snap           = std::make_shared<snapshot>();
+    snap->root          = clone(*root_);
+    snap->static_routes = static_routes_;
+    freeze_node(*snap, snap->root.get());
+
+    snapshot_.store(std::move(snap), std::memory_order_release);
+}
+
+std::shared_ptr<const router_impl::snapshot> router_impl::current() const
+{
+    return snapshot_.load(std::memory_order_acquire);
+}
+
+std::unique_ptr<router_impl::Node> router_impl::clone(const Node& node)
+{
+    auto copy        = std::make_unique<Node>();
+    copy->key        = node.key;
+    copy->param_name = node.param_name;
+    copy->regex      = node.regex;
+    copy->type       = node.type;
+    copy->handlers   = node.handlers; // the entries are shared, not copied
+    copy->ws_handler = node.ws_handler;
+
+    for (const auto& [key, child] : node.static_children)
+        copy->static_children.emplace(key, clone(*child));
+    for (const auto& child : node.param_children)
+        copy->param_children.push_back(clone(*child));
+    for (const auto& child : node.regex_children)
+        copy->regex_children.push_back(clone(*child));
+    if (node.wildcard_children)
+        copy->wildcard_children = clone(*node.wildcard_children);
+    return copy;
 }
 
+bool router_impl::prune(Node& node)
+{
+    std::erase_if(node.static_children, [](auto& v) { return prune(*v.second); });
+    std::erase_if(node.param_children, [](auto& child) { return prune(*child); });
+    std::erase_if(node.regex_children, [](auto& child) { return prune(*child); });
+    if (node.wildcard_children && prune(*node.wildcard_children))
+        node.wildcard_children.reset();
+
+    return node.handlers.empty() && !node.ws_handler && node.static_children.empty() &&
+           node.param_children.empty() && node.regex_children.empty() && !node.wildcard_children;
+}
 
-router_impl::Node* router_impl::insert(Node* parent,
-                                       const std::vector<std::string_view>& segments,
-                                       size_t index)
+std::uint32_t router_impl::freeze_node(snapshot& snap, const Node* node)
+{
+    auto index = static_cast<std::uint32_t>(snap.nodes.size());
+    snap.nodes.emplace_back();
+
+    frozen_node frozen;
+    frozen.node = node;
+    for (const auto& v : node->handlers)
+        frozen.methods |= detail::method_bit(v.first);
+    frozen.allow = detail::join_methods(frozen.methods);
+
+    std::vector<std::pair<std::string_view, const Node*>> statics;
+    statics.reserve(node->static_children.size());
+    for (const auto& [key, child] : node->static_children)
+        statics.emplace_back(key, child.get());
+    std::ranges::sort(statics);
+
+    // reserve this node's ranges first, the children append their own behind them.
+    frozen.static_begin = static_cast<std::uint32_t>(snap.statics.size());
+    frozen.static_end   = frozen.static_begin + static_cast<std::uint32_t>(statics.size());
+    snap.statics.resize(frozen.static_end);
+
+    frozen.regex_begin = static_cast<std::uint32_t>(snap.children.size());
+    frozen.param_begin =
+        frozen.regex_begin + static_cast<std::uint32_t>(node->regex_children.size());
+    frozen.param_end =
+        frozen.param_begin + static_cast<std::uint32_t>(node->param_children.size());
+    snap.children.resize(frozen.param_end);
+
+    for (std::size_t i = 0; i < statics.size(); ++i) {
+        auto [key, child]                     = statics[i];
+        snap.statics[frozen.static_begin + i] = {key, freeze_node(snap, child)};
+    }
+    for (std::size_t i = 0; i < node->regex_children.size(); ++i)
+        snap.children[frozen.regex_begin + i] = freeze_node(snap, node->regex_children[i].get());
+    for (std::size_t i = 0; i < node->param_children.size(); ++i)
+        snap.children[frozen.param_begin + i] = freeze_node(snap, node->param_children[i].get());
+    if (node->wildcard_children)
+        frozen.wildcard = freeze_node(snap, node->wildcard_children.get());
+
+    snap.nodes[index] = std::move(frozen);
+    return index;
+}
+
+
+router_impl::Node*
+router_impl::insert(Node* parent, const segments_type& segments, size_t index)
 {
     if (index >= segments.size())
         return parent;
@@ -85,7 +253,7 @@ router_impl::Node* router_impl::insert(Node* parent,
         node->key        = seg;
         node->type       = Node::node_type::regex_node;
         node->param_name = inside.substr(0, pos);
-        node->regex      = std::regex(key.begin(), key.end());
+        node->regex      = segment_regex(key);
 
         parent->regex_children.push_back(std::move(node));
         return insert(parent->regex_children.back().get(), segments, index + 1);
@@ -103,36 +271,80 @@ router_impl::Node* router_impl::insert(Node* parent,
 // ---------------- 匹配路由 ----------------
 net::awaitable<void> router_impl::proc_routing(request& req, response& resp) const
 {
-    // std::shared_lock lock(mutex_);
-
-    auto segments = detail::split_segments(req.path());
-
-    std::unordered_map<std::string, std::string> params;
-    std::set<std::string> allows;
-
-    auto node = match_nodes(root_.get(), segments, 0, params, [&](const Node* node) {
-        for (const auto& v : node->handlers)
-            allows.insert(to_string(v.first));
-
-        return node->handlers.find(req.method()) != node->handlers.end();
-    });
-
-    if (node) {
-        req.set_path_param(std::move(params));
-        auto iter = node->handlers.find(req.method());
-        if (iter != node->handlers.end()) {
-            co_await iter->second(req, resp);
-            co_return;
-        }
+    const auto& match = route(req);
+    if (match.static_handler) {
+        co_await match.static_handler(req, resp);
+        co_return;
+    }
+    if (match.entry) {
+        co_await match.entry->handler(req, resp);
+        co_return;
     }
-    if (!allows.empty()) {
-        resp.set(http::field::allow, boost::join(allows, ","));
+    if (!match.allow.empty()) {
+        resp.set(http::field::allow, match.allow);
         resp.set_error_content(httplib::http::status::method_not_allowed);
         co_return;
     }
     resp.set_error_content(httplib::http::status::not_found);
 }
 
+request::route_match router_impl::match(http::verb method, std::string_view path) const
+{
+    request::route_match match;
+    auto snap = current();
+    if (!snap)
+        return match;
+
+    std::uint64_t static_allowed = 0;
+    if (snap->static_routes) {
+        match.static_handler = snap->static_routes->find(method, path, static_allowed);
+        if (match.static_handler)
+            return match;
+    }
+
+    match_state state;
+    match_route(*snap, method, path, state);
+
+    // the request owns its entry, removing the route cannot take the handler from under it.
+    match.entry = std::move(state.entry);
+    match.params.reserve(state.params.size());
+    for (const auto& [name, value] : state.params)
+        match.params.emplace_back(name, value);
+
+    // one node with handlers is the common case, its header is ready.
+    if (!match.entry && (state.allowed | static_allowed) != 0) {
+        if (state.allow_node && state.allow_node->methods == (state.allowed | static_allowed))
+            match.allow = state.allow_node->allow;
+        else
+            match.allow = detail::join_methods(state.allowed | static_allowed);
+    }
+    return match;
+}
+
+const request::route_match& router_impl::route(request& req) const
+{
+    if (!req.route())
+        req.set_route(match(req.method(), req.path()));
+    return *req.route();
+}
+
+void router_impl::match_route(const snapshot& snap,
+                              http::verb method,
+                              std::string_view path,
+                              match_state& state) const
+{
+    auto segments = detail::split_segments<segments_type>(path);
+    auto accept   = [&](const frozen_node& node) {
+        if (node.methods != 0 && !state.allow_node)
+            state.allow_node = &node;
+        state.allowed |= node.methods;
+        return (node.methods & detail::method_bit(method)) != 0;
+    };
+    auto index = match_node(snap, 0, path, segments, 0, state.params, accept);
+    if (index != npos)
+        state.entry = snap.nodes[index].node->handlers.find(method)->second;
+}
+
 void router_impl::set_not_found_handler_impl(coro_http_handler_type&& handler)
 {
     not_found_handler_ = std::move(handler);
@@ -143,8 +355,8 @@ void router_impl::set_ws_handler_impl(std::string_view path,
                                       websocket_conn::coro_message_handler_type&& message_handler,
                                       websocket_conn::coro_close_handler_type&& close_handler)
 {
-    // std::unique_lock lock(mutex_);
-    auto segments = detail::split_segments(path);
+    std::lock_guard lock(mutex_);
+    auto segments = detail::split_segments<segments_type>(path);
 
     auto node = insert(root_.get(), segments, 0);
 
@@ -152,26 +364,65 @@ void router_impl::set_ws_handler_impl(std::string_view path,
     entry.open_handler    = std::move(open_handler);
     entry.message_handler = std::move(message_handler);
     entry.close_handler   = std::move(close_handler);
-    node->ws_handler      = std::move(entry);
+    node->ws_handler      = std::make_shared<const ws_handler_entry>(std::move(entry));
+    route_changed();
 }
 
-std::optional<router_impl::ws_handler_entry> router_impl::query_ws_handler(request& req) const
+void router_impl::remove_ws_handler_impl(std::string_view path)
 {
-    // std::shared_lock lock(mutex_);
-    auto segments = detail::split_segments(req.path());
+    std::lock_guard lock(mutex_);
+    auto segments = detail::split_segments<segments_type>(path);
+    insert(root_.get(), segments, 0)->ws_handler.reset();
+    prune(*root_);
+    route_changed();
+}
+
+std::shared_ptr<const router_impl::ws_handler_entry>
+router_impl::query_ws_handler(request& req) const
+{
+    // upgrades skip pre_routing, this is their one match.
+    auto snap = current();
+    if (!snap)
+        return nullptr;
 
-    std::unordered_map<std::string, std::string> params;
-    auto node = match_nodes(root_.get(), segments, 0, params, [&](const Node* node) {
-        return node->ws_handler.has_value();
-    });
+    auto path     = req.path();
+    auto segments = detail::split_segments<segments_type>(path);
 
-    if (!node)
-        return std::nullopt;
+    params_type params;
+    auto accept = [](const frozen_node& node) { return node.node->ws_handler != nullptr; };
+    auto index  = match_node(*snap, 0, path, segments, 0, params, accept);
+    if (index == npos)
+        return nullptr;
+
+    request::route_match match;
+    for (const auto& [name, value] : params)
+        match.params.emplace_back(name, value);
+    req.set_route(std::move(match));
+    return snap->nodes[index].node->ws_handler;
+}
 
-    return node->ws_handler;
+body_mode router_impl::query_body_mode(const request::route_match& match)
+{
+    if (!match.entry)
+        return body_mode::buffered;
+    return match.entry->mode;
 }
+
+bool router_impl::may_suspend(request& req) const
+{
+    if (post_handler_)
+        return true;
+    const auto& match = route(req);
+    if (match.static_handler)
+        return true;
+    if (!match.entry)
+        return not_found_handler_ != nullptr;
+    return match.entry->may_suspend;
+}
+
 net::awaitable<bool> router_impl::pre_routing(request& req, response& resp) const
 {
+    const auto& match = route(req);
     switch (req.method()) {
         case http::verb::get:
         case http::verb::head:
@@ -179,27 +430,12 @@ net::awaitable<bool> router_impl::pre_routing(request& req, response& resp) cons
         case http::verb::connect:
         case http::verb::options: co_return true; break;
         default: {
-            auto segments = detail::split_segments(req.path());
-
-            std::unordered_map<std::string, std::string> params;
-            std::set<std::string> allows;
-
-            auto node = match_nodes(root_.get(), segments, 0, params, [&](const Node* node) {
-                for (const auto& v : node->handlers)
-                    allows.insert(to_string(v.first));
+            if (match.entry || match.static_handler)
+                co_return true;
 
-                return node->handlers.find(req.method()) != node->handlers.end();
-            });
-
-            if (node) {
-                auto iter = node->handlers.find(req.method());
-                if (iter != node->handlers.end()) {
-                    co_return true;
-                }
-            }
-            if (!allows.empty()) {
+            if (!match.allow.empty()) {
                 resp.keep_alive(false);
-                resp.set(http::field::allow, boost::join(allows, ","));
+                resp.set(http::field::allow, match.allow);
                 resp.set_error_content(httplib::http::status::method_not_allowed);
                 co_return false;
             }
@@ -211,69 +447,68 @@ net::awaitable<bool> router_impl::pre_routing(request& req, response& resp) cons
     co_return false;
 }
 
-const router_impl::Node*
-router_impl::match_nodes(const Node* parent,
-                         const std::vector<std::string_view>& segments,
-                         size_t index,
-                         std::unordered_map<std::string, std::string>& params,
-                         const MatchHandlerType& handler) const
+template<typename Accept>
+std::uint32_t router_impl::match_node(const snapshot& snap,
+                                      std::uint32_t index,
+                                      std::string_view path,
+                                      const segments_type& segments,
+                                      size_t depth,
+                                      params_type& params,
+                                      Accept& accept) const
 {
-    if (!parent)
-        return nullptr;
-
-    if (index == segments.size()) {
-        if (!handler(parent))
-            return nullptr;
-        return parent;
-    }
+    const auto& parent = snap.nodes[index];
+    if (depth == segments.size())
+        return accept(parent) ? index : npos;
 
-    const auto& seg = segments[index];
+    auto seg = segments[depth];
 
     // 1) static
     {
-        auto iter = parent->static_children.find(std::string(seg));
-        if (iter != parent->static_children.end()) {
-            if (auto node = match_nodes(iter->second.get(), segments, index + 1, params, handler);
-                node)
+        auto first = snap.statics.begin() + parent.static_begin;
+        auto last  = snap.statics.begin() + parent.static_end;
+        auto iter  = std::ranges::lower_bound(first, last, seg, {}, &frozen_edge::key);
+        if (iter != last && iter->key == seg) {
+            if (auto node =
+                    match_node(snap, iter->node, path, segments, depth + 1, params, accept);
+                node != npos)
                 return node;
         }
     }
 
     // 2) regex
-    for (auto& child : parent->regex_children) {
-        if (std::regex_match(seg.data(), seg.data() + seg.length(), child->regex)) {
-            params[child->param_name] = std::string(seg);
-            if (auto node = match_nodes(child.get(), segments, index + 1, params, handler); node)
+    for (auto i = parent.regex_begin; i < parent.param_begin; ++i) {
+        auto child = snap.nodes[snap.children[i]].node;
+        if (child->regex.match(seg)) {
+            params.emplace_back(child->param_name, seg);
+            if (auto node =
+                    match_node(snap, snap.children[i], path, segments, depth + 1, params, accept);
+                node != npos)
                 return node;
-
-            params.erase(child->param_name);
+            params.pop_back();
         }
     }
 
     // 3) param
-    for (auto& child : parent->param_children) {
-        params[child->param_name] = std::string(seg);
-        if (auto node = match_nodes(child.get(), segments, index + 1, params, handler); node)
+    for (auto i = parent.param_begin; i < parent.param_end; ++i) {
+        auto child = snap.nodes[snap.children[i]].node;
+        params.emplace_back(child->param_name, seg);
+        if (auto node =
+                match_node(snap, snap.children[i], path, segments, depth + 1, params, accept);
+            node != npos)
             return node;
-        params.erase(child->param_name);
+        params.pop_back();
     }
 
-    // 4) wildcard
-    if (parent->wildcard_children) {
-        std::string rest;
-        for (size_t i = index; i < segments.size(); ++i) {
-            if (!rest.empty())
-                rest += "/";
-            rest += segments[i];
-        }
-        params["*"] = std::move(rest);
-        if (auto node = match_nodes(
-                parent->wildcard_children.get(), segments, segments.size(), params, handler);
-            node)
+    // 4) wildcard, the rest of the path
+    if (parent.wildcard != npos) {
+        params.emplace_back("*", path.substr(seg.data() - path.data()));
+        if (auto node =
+                match_node(snap, parent.wildcard, path, segments, segments.size(), params, accept);
+            node != npos)
             return node;
-        params.erase("*");
+        params.pop_back();
     }
-    return nullptr;
+    return npos;
 }
 
 net::awaitable<void> router_impl::post_routing(request& req, response& resp) const
@@ -292,5 +527,12 @@ void router_impl::set_http_post_handler_impl(coro_http_handler_type&& handler)
     post_handler_ = std::move(handler);
 }
 
+void router_impl::set_static_routes_impl(std::unique_ptr<static_route_table>&& table)
+{
+    std::lock_guard lock(mutex_);
+    static_routes_ = std::move(table);
+    route_changed();
+}
+
 
 } // namespace httplib::server
\ No newline at end of file
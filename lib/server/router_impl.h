@@ -2,22 +2,36 @@
 #include "httplib/server/request.hpp"
 #include "httplib/server/response.hpp"
 #include "httplib/server/router.hpp"
+#include "segment_regex.hpp"
 #include <boost/beast/http.hpp>
+#include <boost/container/small_vector.hpp>
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
-#include <regex>
-#include <shared_mutex>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace httplib::server {
 
+// a route's handler for one method; a matched request points at it (request::route).
+struct route_entry
+{
+    std::function<net::awaitable<void>(request& req, response& resp)> handler;
+    body_mode mode = body_mode::buffered;
+    // false for a plain function without aspects: it runs to completion without waiting.
+    bool may_suspend = true;
+};
+
 class router_impl : public router
 {
 public:
     router_impl();
 
+    void freeze() override;
+
     net::awaitable<void> proc_routing(request& req, response& resp) const;
 
     struct ws_handler_entry
@@ -26,21 +40,37 @@ public:
         websocket_conn::coro_close_handler_type close_handler;
         websocket_conn::coro_message_handler_type message_handler;
     };
-    std::optional<ws_handler_entry> query_ws_handler(request& req) const;
+    std::shared_ptr<const ws_handler_entry> query_ws_handler(request& req) const;
+
+    // matches `path` for `method`, for a request that does not exist yet (HTTP/2 streams).
+    request::route_match match(http::verb method, std::string_view path) const;
+    // the route of the request, matched on first use.
+    const request::route_match& route(request& req) const;
 
     net::awaitable<bool> pre_routing(request& req, response& resp) const;
+    // how the handler of the request wants its body, buffered when there is none.
+    static body_mode query_body_mode(const request::route_match& match);
+    // whether serving the request may wait on something, the post and not found handlers
+    // included.
+    bool may_suspend(request& req) const;
     net::awaitable<void> post_routing(request& req, response& resp) const;
 
 protected:
     void set_http_handler_impl(http::verb method,
                                std::string_view path,
-                               coro_http_handler_type&& handler) override;
+                               coro_http_handler_type&& handler,
+                               body_mode mode,
+                               bool may_suspend) override;
     void set_not_found_handler_impl(coro_http_handler_type&& handler) override;
     void set_ws_handler_impl(std::string_view path,
                              websocket_conn::coro_open_handler_type&& open_handler,
                              websocket_conn::coro_message_handler_type&& message_handler,
                              websocket_conn::coro_close_handler_type&& close_handler) override;
     void set_http_post_handler_impl(coro_http_handler_type&& handler) override;
+    void set_static_routes_impl(std::unique_ptr<static_route_table>&& table) override;
+    void remove_http_handler_impl(http::verb method, std::string_view path) override;
+    void remove_ws_handler_impl(std::string_view path) override;
+    void update_impl(const std::function<void()>& changes) override;
 
 private:
     struct Node
@@ -55,11 +85,12 @@ private:
 
         std::string key; // Radix key (静态路径段)
         std::string param_name;
-        std::regex regex;
+        segment_regex regex;
         node_type type = node_type::static_node;
 
-        std::unordered_map<http::verb, coro_http_handler_type> handlers;
-        std::optional<ws_handler_entry> ws_handler;
+        // shared by every snapshot the node is copied into, the handlers run in place.
+        std::unordered_map<http::verb, std::shared_ptr<const route_entry>> handlers;
+        std::shared_ptr<const ws_handler_entry> ws_handler;
 
         std::unordered_map<std::string, std::unique_ptr<Node>> static_children;
         std::vector<std::unique_ptr<Node>> param_children;
@@ -67,21 +98,90 @@ private:
         std::unique_ptr<Node> wildcard_children;
     };
 
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    struct frozen_node
+    {
+        const Node* node           = nullptr;
+        std::uint32_t static_begin = 0;
+        std::uint32_t static_end   = 0;
+        // regex children, then param children, in snapshot::children
+        std::uint32_t regex_begin = 0;
+        std::uint32_t param_begin = 0;
+        std::uint32_t param_end   = 0;
+        std::uint32_t wildcard    = npos;
+        // one bit per http::verb with a handler, and the matching Allow header
+        std::uint64_t methods = 0;
+        std::string allow;
+    };
+
+    struct frozen_edge
+    {
+        std::string_view key;
+        std::uint32_t node = 0;
+    };
+
+    // What requests are matched against: a copy of the route tree's structure laid out in three
+    // flat arrays (nodes, static edges and the other children), each node's ranges contiguous and
+    // its static edges sorted, pointing into the keys of `root`. Never changed once published,
+    // a change publishes a new snapshot.
+    struct snapshot
+    {
+        std::unique_ptr<Node> root;
+        std::shared_ptr<const static_route_table> static_routes;
+        std::vector<frozen_node> nodes;
+        std::vector<frozen_edge> statics;
+        std::vector<std::uint32_t> children;
+    };
+
+    using segments_type = boost::container::small_vector<std::string_view, 16>;
+    using params_type =
+        boost::container::small_vector<std::pair<std::string_view, std::string_view>, 4>;
+
+    struct match_state
+    {
+        std::shared_ptr<const route_entry> entry;
+        params_type params;
+        // methods of every node the path reached, for a 405.
+        std::uint64_t allowed         = 0;
+        const frozen_node* allow_node = nullptr;
+    };
+
+    // writers register into root_ under mutex_ and publish copies of it; readers only load the
+    // published snapshot.
+    std::recursive_mutex mutex_;
     std::unique_ptr<Node> root_;
-    // mutable std::shared_mutex mutex_;
+    std::shared_ptr<const static_route_table> static_routes_;
+    bool frozen_ = false;
+    int batch_   = 0;
+
+    std::atomic<std::shared_ptr<const snapshot>> snapshot_;
 
     coro_http_handler_type post_handler_;
     coro_http_handler_type not_found_handler_;
 
-    // 内部函数
-    static Node* insert(Node* node, const std::vector<std::string_view>& segments, size_t index);
+    static Node* insert(Node* node, const segments_type& segments, size_t index);
+    // drops the nodes left without handlers or children below `node`.
+    static bool prune(Node& node);
+    static std::unique_ptr<Node> clone(const Node& node);
+    static std::uint32_t freeze_node(snapshot& snap, const Node* node);
+    void route_changed();
+    void publish();
+    // the published snapshot, null before freeze().
+    std::shared_ptr<const snapshot> current() const;
 
-    using MatchHandlerType = std::function<bool(const Node* node)>;
+    void match_route(const snapshot& snap,
+                     http::verb method,
+                     std::string_view path,
+                     match_state& state) const;
 
-    const Node* match_nodes(const Node* node,
-                            const std::vector<std::string_view>& segments,
-                            size_t index,
-                            std::unordered_map<std::string, std::string>& params,
-                            const MatchHandlerType& handler) const;
+    template<typename Accept>
+    std::uint32_t match_node(const snapshot& snap,
+                             std::uint32_t index,
+                             std::string_view path,
+                             const segments_type& segments,
+                             size_t depth,
+                             params_type& params,
+                             Accept& accept) const;
 };
 } // namespace httplib::server
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "segment_regex.hpp"
+#include <algorithm>
+#include <boost/container/small_vector.hpp>
+#include <cctype>
+#include <limits>
+
+namespace httplib::server {
+
+namespace detail {
+
+static constexpr std::uint32_t unbounded = std::numeric_limits<std::uint32_t>::max();
+
+static void add_range(std::bitset<256>& set, unsigned char first, unsigned char last)
+{
+    for (unsigned c = first; c <= last; ++c)
+        set.set(c);
+}
+
+// \d \w \s and their negations, as ECMAScript defines them for single bytes.
+static bool add_class_escape(std::bitset<256>& set, char c)
+{
+    std::bitset<256> cls;
+    switch (std::tolower(static_cast<unsigned char>(c))) {
+        case 'd': add_range(cls, '0', '9'); break;
+        case 'w':
+            add_range(cls, '0', '9');
+            add_range(cls, 'a', 'z');
+            add_range(cls, 'A', 'Z');
+            cls.set('_');
+            break;
+        case 's':
+            for (char ws : {' ', '\t', '\n', '\r', '\f', '\v'})
+                cls.set(static_cast<unsigned char>(ws));
+            break;
+        default: return false;
+    }
+    set |= std::isupper(static_cast<unsigned char>(c)) ? ~cls : cls;
+    return true;
+}
+
+// an escaped character that stands for itself.
+static bool is_identity_escape(char c)
+{
+    return std::ispunct(static_cast<unsigned char>(c)) != 0;
+}
+
+static bool parse_number(std::string_view pattern, std::size_t& pos, std::uint32_t& value)
+{
+    auto start = pos;
+    value      = 0;
+    while (pos < pattern.size() && std::isdigit(static_cast<unsigned char>(pattern[pos]))) {
+        value = value * 10 + static_cast<std::uint32_t>(pattern[pos] - '0');
+        if (value > 65535)
+            return false;
+        ++pos;
+    }
+    return pos != start;
+}
+
+} // namespace detail
+
+segment_regex::segment_regex(std::string_view pattern)
+{
+    if (!compile(pattern)) {
+        atoms_.clear();
+        fallback_.emplace(pattern.begin(), pattern.end());
+        return;
+    }
+    fixed_width_ = std::ranges::all_of(atoms_, [](const atom& a) { return a.min == a.max; });
+}
+
+bool segment_regex::compile(std::string_view pattern)
+{
+    // the whole segment is matched, the anchors say nothing more.
+    if (pattern.starts_with('^'))
+        pattern.remove_prefix(1);
+    if (pattern.ends_with('$')) {
+        // unless it is an escaped '$'
+        std::size_t escapes = 0;
+        while (escapes + 1 < pattern.size() && pattern[pattern.size() - 2 - escapes] == '\\')
+            ++escapes;
+        if (escapes % 2 == 0)
+            pattern.remove_suffix(1);
+    }
+
+    std::size_t pos = 0;
+    while (pos < pattern.size()) {
+        atom a;
+        auto c = pattern[pos++];
+        switch (c) {
+            case '\\': {
+                if (pos == pattern.size())
+                    return false;
+                auto e = pattern[pos++];
+                if (!detail::add_class_escape(a.chars, e)) {
+                    if (!detail::is_identity_escape(e))
+                        return false;
+                    a.chars.set(static_cast<unsigned char>(e));
+                }
+            } break;
+            case '[': {
+                bool negate = pos < pattern.size() && pattern[pos] == '^';
+                if (negate)
+                    ++pos;
+                // "[]" is the empty set in ECMAScript, not a literal ']'; leave it to std::regex.
+                if (pos < pattern.size() && pattern[pos] == ']')
+                    return false;
+                for (;;) {
+                    if (pos == pattern.size())
+                        return false;
+                    auto lo = pattern[pos++];
+                    if (lo == ']')
+                        break;
+                    if (lo == '[')
+                        return false; // [:alpha:] and friends
+                    if (lo == '\\') {
+                        if (pos == pattern.size())
+                            return false;
+                        auto e = pattern[pos++];
+                        if (detail::add_class_escape(a.chars, e)) {
+                            // a class as a range bound, [\d-z], is an error std::regex reports.
+                            if (pos + 1 < pattern.size() && pattern[pos] == '-' &&
+                                pattern[pos + 1] != ']')
+                                return false;
+                            continue;
+                        }
+                        if (!detail::is_identity_escape(e))
+                            return false;
+                        lo = e;
+                    }
+                    if (pos + 1 < pattern.size() && pattern[pos] == '-' && pattern[pos + 1] != ']')
+                    {
+                        auto hi = pattern[pos + 1];
+                        if (hi == '[' || hi == '\\')
+                            return false;
+                        if (static_cast<unsigned char>(hi) < static_cast<unsigned char>(lo))
+                            return false;
+                        detail::add_range(a.chars,
+                                          static_cast<unsigned char>(lo),
+                                          static_cast<unsigned char>(hi));
+                        pos += 2;
+                        continue;
+                    }
+                    a.chars.set(static_cast<unsigned char>(lo));
+                }
+                if (negate)
+                    a.chars.flip();
+            } break;
+            case '.':
+                a.chars.set();
+                a.chars.reset('\n');
+                a.chars.reset('\r');
+                break;
+            case '(':
+            case ')':
+            case '|':
+            case '{':
+            case '}':
+            case '*':
+            case '+':
+            case '?':
+            case '^':
+            case '$':
+            case ']': return false;
+            default: a.chars.set(static_cast<unsigned char>(c)); break;
+        }
+
+        // quantifier, greedy or lazy is all the same to a whole-segment match.
+        if (pos < pattern.size()) {
+            switch (pattern[pos]) {
+                case '*': a.min = 0, a.max = detail::unbounded, ++pos; break;
+                case '+': a.min = 1, a.max = detail::unbounded, ++pos; break;
+                case '?': a.min = 0, a.max = 1, ++pos; break;
+                case '{': {
+                    ++pos;
+                    if (!detail::parse_number(pattern, pos, a.min) || pos == pattern.size())
+                        return false;
+                    a.max = a.min;
+                    if (pattern[pos] == ',') {
+                        ++pos;
+                        a.max = detail::unbounded;
+                        if (pos < pattern.size() && pattern[pos] != '}' &&
+                            !detail::parse_number(pattern, pos, a.max))
+                            return false;
+                    }
+                    if (pos == pattern.size() || pattern[pos] != '}' || a.max < a.min)
+                        return false;
+                    ++pos;
+                } break;
+                default: break;
+            }
+            if (a.max != 1 || a.min != 1) {
+                if (pos < pattern.size() && pattern[pos] == '?')
+                    ++pos;
+            }
+        }
+        atoms_.push_back(a);
+    }
+    return true;
+}
+
+bool segment_regex::match(std::string_view value) const
+{
+    if (fallback_)
+        return std::regex_match(value.begin(), value.end(), *fallback_);
+
+    const auto size = value.size();
+
+    // one class with a quantifier, \d+ and the like: no positions to track.
+    if (atoms_.size() == 1) {
+        const auto& a = atoms_.front();
+        if (size < a.min || size > a.max)
+            return false;
+        return std::ranges::all_of(
+            value, [&](char c) { return a.chars.test(static_cast<unsigned char>(c)); });
+    }
+
+    // no choice where an atom ends, one pass over the bytes.
+    if (fixed_width_) {
+        std::size_t p = 0;
+        for (const auto& a : atoms_) {
+            if (size - p < a.min)
+                return false;
+            for (auto end = p + a.min; p < end; ++p) {
+                if (!a.chars.test(static_cast<unsigned char>(value[p])))
+                    return false;
+            }
+        }
+        return p == size;
+    }
+
+    // the positions reachable after each atom; a path segment fits the inline buffer.
+    boost::container::small_vector<std::uint8_t, 256> reach(size + 1, 0);
+    boost::container::small_vector<std::uint8_t, 256> next(size + 1, 0);
+    reach[0] = 1;
+
+    for (const auto& a : atoms_) {
+        std::fill(next.begin(), next.end(), 0);
+        bool any = false;
+        for (std::size_t p = 0; p <= size; ++p) {
+            if (!reach[p])
+                continue;
+            if (a.min == 0)
+                next[p] = any = true;
+
+            std::size_t q     = p;
+            std::uint32_t run = 0;
+            while (q < size && run < a.max && a.chars.test(static_cast<unsigned char>(value[q]))) {
+                ++q;
+                ++run;
+                if (run >= a.min)
+                    next[q] = any = true;
+            }
+        }
+        if (!any)
+            return false;
+        reach.swap(next);
+    }
+    return reach[size] != 0;
+}
+
+} // namespace httplib::server
@@ -0,0 +1,42 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <optional>
+#include <regex>
+#include <string_view>
+#include <vector>
+
+namespace httplib::server {
+
+// The pattern of a `{name:regex}` route segment, matched against the whole segment. What routes
+// actually use - literals and character classes with quantifiers, like \d+, [a-z0-9-]+ or a
+// UUID - is compiled into a list of byte sets checked without std::regex. Anything else
+// (groups, alternation, assertions, back references) falls back to std::regex.
+class segment_regex
+{
+public:
+    segment_regex() = default;
+    // throws std::regex_error for an invalid pattern, like std::regex.
+    explicit segment_regex(std::string_view pattern);
+
+    bool match(std::string_view value) const;
+    bool is_native() const { return !fallback_; }
+
+private:
+    struct atom
+    {
+        std::bitset<256> chars;
+        std::uint32_t min = 1;
+        std::uint32_t max = 1;
+    };
+
+    bool compile(std::string_view pattern);
+
+private:
+    std::vector<atom> atoms_;
+    // every atom takes a fixed count, like a UUID: each byte belongs to one known atom.
+    bool fixed_width_ = false;
+    std::optional<std::regex> fallback_;
+};
+
+} // namespace httplib::server
@@ -1,5 +1,6 @@
 
 #include "httplib/server/server.hpp"
+#include "body/compressor.hpp"
 #include "httplib/server/router.hpp"
 #include "server_impl.h"
 
@@ -57,6 +58,18 @@ http_server& http_server::listen(uint16_t port,
     return listen("0.0.0.0", port, backlog);
 }
 
+http_server& http_server::set_reuse_port_shards(
+    std::size_t count /*= std::thread::hardware_concurrency()*/)
+{
+    impl_->set_reuse_port_shards(count);
+    return *this;
+}
+
+std::size_t http_server::reuse_port_shards() const
+{
+    return impl_->reuse_port_shards();
+}
+
 net::awaitable<boost::system::error_code> http_server::co_run()
 {
     co_return co_await impl_->co_run();
@@ -71,6 +84,22 @@ void http_server::stop()
 {
     impl_->stop();
 }
+
+net::awaitable<bool> http_server::async_drain(const std::chrono::steady_clock::duration& timeout)
+{
+    co_return co_await impl_->async_drain(timeout);
+}
+
+bool http_server::draining() const
+{
+    return impl_->draining();
+}
+
+std::size_t http_server::in_flight_requests() const
+{
+    return impl_->in_flight_requests();
+}
+
 router& http_server::router()
 {
     return impl_->router();
@@ -81,6 +110,11 @@ tcp::endpoint http_server::local_endpoint() const
     return impl_->local_endpoint();
 }
 
+std::size_t http_server::connection_count() const
+{
+    return impl_->connection_count();
+}
+
 void http_server::set_read_timeout(const std::chrono::steady_clock::duration& dur)
 {
     impl_->set_read_timeout(dur);
@@ -91,6 +125,16 @@ void http_server::set_write_timeout(const std::chrono::steady_clock::duration& d
     impl_->set_write_timeout(dur);
 }
 
+void http_server::set_keep_alive_timeout(const std::chrono::steady_clock::duration& dur)
+{
+    impl_->set_keep_alive_timeout(dur);
+}
+
+void http_server::set_header_timeout(const std::chrono::steady_clock::duration& dur)
+{
+    impl_->set_header_timeout(dur);
+}
+
 const std::chrono::steady_clock::duration& http_server::read_timeout() const
 {
     return impl_->read_timeout();
@@ -100,6 +144,116 @@ const std::chrono::steady_clock::duration& http_server::write_timeout() const
 {
     return impl_->write_timeout();
 }
+
+const std::chrono::steady_clock::duration& http_server::keep_alive_timeout() const
+{
+    return impl_->keep_alive_timeout();
+}
+
+const std::chrono::steady_clock::duration& http_server::header_timeout() const
+{
+    return impl_->header_timeout();
+}
+
+void http_server::set_http2_max_concurrent_streams(std::uint32_t count)
+{
+    impl_->set_http2_max_concurrent_streams(count);
+}
+
+std::uint32_t http_server::http2_max_concurrent_streams() const
+{
+    return impl_->http2_max_concurrent_streams();
+}
+
+void http_server::set_compression_level(std::string_view encoding, int level)
+{
+    body::compressor_factory::instance().set_level(encoding, level);
+}
+
+int http_server::compression_level(std::string_view encoding)
+{
+    return body::compressor_factory::instance().level(encoding);
+}
+
+void http_server::set_compression_policy(compression_policy policy)
+{
+    impl_->set_compression_policy(std::move(policy));
+}
+
+const compression_policy& http_server::get_compression_policy() const
+{
+    return impl_->get_compression_policy();
+}
+
+void http_server::set_upload_directory(const fs::path& dir)
+{
+    impl_->set_upload_directory(dir);
+}
+
+const fs::path& http_server::upload_directory() const
+{
+    return impl_->upload_directory();
+}
+
+void http_server::set_upload_direct_io(bool enabled)
+{
+    impl_->set_upload_direct_io(enabled);
+}
+
+bool http_server::upload_direct_io() const
+{
+    return impl_->upload_direct_io();
+}
+
+void http_server::set_upload_limit(std::uint64_t bytes)
+{
+    impl_->set_upload_limit(bytes);
+}
+
+std::uint64_t http_server::upload_limit() const
+{
+    return impl_->upload_limit();
+}
+
+void http_server::set_form_data_spill_size(std::size_t bytes)
+{
+    impl_->set_form_data_spill_size(bytes);
+}
+
+std::size_t http_server::form_data_spill_size() const
+{
+    return impl_->form_data_spill_size();
+}
+void http_server::set_max_connections(std::size_t count)
+{
+    impl_->limiter().set_max_connections(count);
+}
+
+void http_server::set_max_connections_per_ip(std::size_t count)
+{
+    impl_->limiter().set_max_connections_per_ip(count);
+}
+
+void http_server::set_reject_on_overload(bool enabled)
+{
+    impl_->limiter().set_reject_on_overload(enabled);
+}
+
+std::size_t http_server::max_connections() const
+{
+    return impl_->limiter().max_connections();
+}
+
+std::size_t http_server::max_connections_per_ip() const
+{
+    return impl_->limiter().max_connections_per_ip();
+}
+
+bool http_server::reject_on_overload() const
+{
+    return impl_->limiter().reject_on_overload();
+}
+
 std::shared_ptr<spdlog::logger> http_server::get_logger() const
 {
     return impl_->get_logger();
@@ -109,6 +263,16 @@ void http_server::set_logger(std::shared_ptr<spdlog::logger> logger)
     impl_->set_logger(logger);
 }
 
+void http_server::set_access_log(const fs::path& file, access_log_format format)
+{
+    impl_->set_access_log(file, format);
+}
+
+std::uint64_t http_server::access_log_dropped() const
+{
+    return impl_->access_log_dropped();
+}
+
 void http_server::use_ssl(const std::span<const char>& cert_file,
                           const std::span<const char>& key_file,
                           std::string passwd /*= {}*/)
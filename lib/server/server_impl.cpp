@@ -1,6 +1,11 @@
 #include "server_impl.h"
 #include "httplib/util/use_awaitable.hpp"
 #include "httplib/util/when_all.hpp"
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/experimental/parallel_group.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/beast/core/string.hpp>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -9,11 +14,64 @@
 #include <openssl/ssl.h>
 #endif
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace httplib::server {
 
+namespace detail {
+static void open_acceptor(tcp::acceptor& acceptor,
+                          const tcp::endpoint& endp,
+                          int backlog,
+                          bool reuse_port)
+{
+    acceptor.open(endp.protocol());
+#ifndef _WIN32
+    acceptor.set_option(tcp::acceptor::reuse_address(true));
+#endif
+#ifdef SO_REUSEPORT
+    if (reuse_port)
+        acceptor.set_option(net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+#endif
+    acceptor.bind(endp);
+    acceptor.listen(backlog);
+}
+
+static void pin_thread_to_cpu(std::thread& thread, std::size_t index)
+{
+#ifdef __linux__
+    auto cpu_count = std::max(1u, std::thread::hardware_concurrency());
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(index % cpu_count, &cpu_set);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+static bool is_multipart_form_data(std::string_view content_type)
+{
+    static constexpr std::string_view type = "multipart/form-data";
+    return content_type.size() >= type.size() &&
+           beast::iequals(content_type.substr(0, type.size()), type);
+}
+
+} // namespace detail
+
+http_server::impl::io_shard::io_shard(std::size_t index)
+    : index(index)
+    , ioc(1)
+    , acceptor(ioc)
+    , work(net::make_work_guard(ioc))
+{
+}
+
 http_server::impl::impl(const net::any_io_executor& ex)
     : ex_(ex)
     , acceptor_(ex)
+    , sessions_(std::thread::hardware_concurrency())
 {
     auto console_sink                 = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
     spdlog::sinks_init_list sink_list = {console_sink};
@@ -21,6 +79,21 @@ http_server::impl::impl(const net::any_io_executor& ex)
     default_logger_->set_level(spdlog::level::info);
 }
 
+http_server::impl::~impl()
+{
+    for (auto& shard : shards_) {
+        shard->work.reset();
+        shard->ioc.stop();
+        if (!shard->thread.joinable())
+            continue;
+
+        if (shard->thread.get_id() == std::this_thread::get_id())
+            shard->thread.detach();
+        else
+            shard->thread.join();
+    }
+}
+
 void http_server::impl::listen(std::string_view host,
                                uint16_t port,
                                int backlog /*= net::socket_base::max_listen_connections*/)
@@ -29,13 +102,22 @@ void http_server::impl::listen(std::string_view host,
     auto results = resolver.resolve(host, std::to_string(port));
 
     tcp::endpoint endp(*results.begin());
-    acceptor_.open(endp.protocol());
-#ifndef _WIN32
-    acceptor_.set_option(tcp::acceptor::reuse_address(true));
-#endif
-    acceptor_.bind(endp);
-    acceptor_.listen(backlog);
+    if (shard_count_ == 0) {
+        detail::open_acceptor(acceptor_, endp, backlog, false);
+    }
+    else {
+        // one registry shard per io shard, each only ever touched from its own thread.
+        sessions_.resize(shard_count_);
+        for (std::size_t i = 0; i < shard_count_; ++i) {
+            auto shard = std::make_unique<io_shard>(i);
+            detail::open_acceptor(shard->acceptor, endp, backlog, true);
+            // let every following shard join the port the kernel picked for the first one.
+            if (endp.port() == 0)
+                endp = shard->acceptor.local_endpoint();
 
+            shards_.push_back(std::move(shard));
+        }
+    }
 
     auto listen_endp = local_endpoint();
     get_logger()->info(
@@ -47,6 +129,21 @@ net::any_io_executor http_server::impl::get_executor() noexcept
     return ex_;
 }
 
+void http_server::impl::set_reuse_port_shards(std::size_t count)
+{
+#ifndef SO_REUSEPORT
+    if (count > 0)
+        throw boost::system::system_error(
+            boost::system::errc::make_error_code(boost::system::errc::operation_not_supported));
+#endif
+    shard_count_ = count;
+}
+
+std::size_t http_server::impl::reuse_port_shards() const
+{
+    return shard_count_;
+}
+
 void http_server::impl::async_run()
 {
     net::co_spawn(
@@ -65,14 +162,74 @@ void http_server::impl::async_run()
 
 void http_server::impl::stop()
 {
+    stop_accept();
+    sessions_.abort_all();
+}
+
+void http_server::impl::stop_accept()
+{
+    // acceptors parked on the connection limit see the closed acceptor once woken up.
     boost::system::error_code ec;
     acceptor_.cancel(ec);
     acceptor_.close(ec);
+    limiter_.wake_waiters();
+    for (auto& shard : shards_) {
+        net::post(shard->ioc, [this, shard = shard.get()]() {
+            boost::system::error_code ec;
+            shard->acceptor.cancel(ec);
+            shard->acceptor.close(ec);
+            limiter_.wake_waiters();
+        });
+    }
+}
+
+net::awaitable<bool>
+http_server::impl::async_drain(const std::chrono::steady_clock::duration& timeout)
+{
+    using namespace std::chrono_literals;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    // the flag must be visible before the sessions are walked, see http_task::then().
+    draining_ = true;
+    stop_accept();
+    for (std::size_t i = 0; i < sessions_.shard_count(); ++i)
+        sessions_.at(i).for_each([](session& conn) { conn.drain(); });
+
+    // every request that ends from now on wakes the waiter up, which counts again. The waiter
+    // runs on a strand of its own so a wake-up can not slip in between the count and the wait.
+    auto waiter = std::make_shared<drain_waiter>(
+        net::make_strand(co_await net::this_coro::executor));
     {
-        std::lock_guard lck(session_mutex_);
-        for (const auto& v : session_map_)
-            v->abort();
+        std::lock_guard lck(drain_mutex_);
+        drain_waiter_ = waiter;
     }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    co_await net::co_spawn(
+        waiter->strand,
+        [this, waiter, deadline]() -> net::awaitable<void> {
+            boost::system::error_code ec;
+            while (in_flight_requests() != 0 && std::chrono::steady_clock::now() < deadline) {
+                if (std::exchange(waiter->woken, false))
+                    continue;
+                waiter->timer.expires_at(deadline);
+                co_await waiter->timer.async_wait(util::net_awaitable[ec]);
+            }
+        },
+        net::use_awaitable);
+    {
+        std::lock_guard lck(drain_mutex_);
+        drain_waiter_.reset();
+    }
+    bool drained = in_flight_requests() == 0;
+
+    // whatever is left is idle or not http (websocket, tunnels).
+    sessions_.abort_all();
+    co_return drained;
+}
+
+bool http_server::impl::draining() const
+{
+    return draining_;
 }
 
 router_impl& http_server::impl::router()
@@ -80,38 +237,180 @@ router_impl& http_server::impl::router()
     return router_;
 }
 
+std::size_t http_server::impl::connection_count() const
+{
+    return sessions_.size();
+}
+
+void http_server::impl::request_finished()
+{
+    in_flight_.decrement();
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!draining_.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard lck(drain_mutex_);
+    if (drain_waiter_) {
+        net::post(drain_waiter_->strand, [waiter = drain_waiter_]() {
+            waiter->woken = true;
+            waiter->timer.cancel();
+        });
+    }
+}
+
+std::size_t http_server::impl::in_flight_requests() const
+{
+    return static_cast<std::size_t>(std::max<std::ptrdiff_t>(in_flight_.load(), 0));
+}
+
 net::awaitable<boost::system::error_code> http_server::impl::co_run()
 {
+    router_.freeze();
+    if (!shards_.empty())
+        co_return co_await co_run_shards();
+
+    stopped_ = false;
+    // the deadline loops are joined like the acceptors, none of them outlives co_run().
+    std::vector<net::awaitable<void>> expires;
+    for (std::size_t i = 0; i < sessions_.shard_count(); ++i)
+        expires.push_back(co_expire(sessions_.at(i)));
+
     std::vector<net::awaitable<boost::system::error_code>> ops;
     for (int i = 0; i < 32; ++i)
-        ops.push_back(co_accept());
+        ops.push_back(co_accept(acceptor_, sessions_.at(i)));
 
-    auto&& results = co_await util::when_all(std::move(ops));
-    {
-        std::lock_guard lck(session_mutex_);
-        for (const auto& v : session_map_)
-            v->abort();
+    auto accept = [&]() -> net::awaitable<std::vector<boost::system::error_code>> {
+        auto results = co_await util::when_all(std::move(ops));
+        stopped_     = true;
+        if (!draining_)
+            sessions_.abort_all();
+        co_return results;
+    };
+
+    using namespace net::experimental::awaitable_operators;
+    auto results = co_await (accept() && util::when_all(std::move(expires)));
+
+    for (const auto& ec : results)
+        if (ec)
+            co_return ec;
+
+    co_return boost::system::error_code {};
+}
+
+net::awaitable<boost::system::error_code> http_server::impl::co_run_shards()
+{
+    // every shard accepts on its own io_context, sessions spawned from there never leave it.
+    auto spawn_accept = [this](io_shard& shard) {
+        return net::co_spawn(
+            shard.ioc, co_accept(shard.acceptor, sessions_.at(shard.index)), net::deferred);
+    };
+
+    auto spawn_expire = [this](io_shard& shard) {
+        return net::co_spawn(shard.ioc, co_expire(sessions_.at(shard.index)), net::deferred);
+    };
+
+    stopped_ = false;
+    std::vector<decltype(spawn_accept(*shards_.front()))> ops;
+    std::vector<decltype(spawn_expire(*shards_.front()))> expires;
+    for (auto& shard : shards_) {
+        expires.push_back(spawn_expire(*shard));
+        ops.push_back(spawn_accept(*shard));
     }
 
+    using accept_result =
+        std::pair<std::vector<std::exception_ptr>, std::vector<boost::system::error_code>>;
+    auto accept = [&]() -> net::awaitable<accept_result> {
+        auto [orders, exceptions, results] =
+            co_await net::experimental::make_parallel_group(std::move(ops))
+                .async_wait(net::experimental::wait_for_all(), net::deferred);
+        stopped_ = true;
+        if (!draining_)
+            sessions_.abort_all();
+        co_return accept_result {std::move(exceptions), std::move(results)};
+    };
+    // the deadline loops run until their shard is empty, the io_contexts are released after.
+    auto join_expire = [&]() -> net::awaitable<void> {
+        co_await net::experimental::make_parallel_group(std::move(expires))
+            .async_wait(net::experimental::wait_for_all(), net::deferred);
+    };
+
+    start_shard_threads();
+
+    using namespace net::experimental::awaitable_operators;
+    auto [exceptions, results] = co_await (accept() && join_expire());
+
+    for (auto& shard : shards_)
+        net::post(shard->ioc, [shard = shard.get()]() { shard->work.reset(); });
+
+    for (const auto& ex : exceptions)
+        if (ex)
+            std::rethrow_exception(ex);
+
     for (const auto& ec : results)
         if (ec)
             co_return ec;
 
     co_return boost::system::error_code {};
 }
-net::awaitable<boost::system::error_code> http_server::impl::co_accept()
+
+void http_server::impl::start_shard_threads()
+{
+    for (auto& shard : shards_) {
+        if (shard->thread.joinable())
+            continue;
+
+        shard->thread = std::thread([shard = shard.get()]() { shard->ioc.run(); });
+        detail::pin_thread_to_cpu(shard->thread, shard->index);
+    }
+}
+
+net::awaitable<void> http_server::impl::co_expire(session_registry::shard& sessions)
 {
+    using namespace std::chrono_literals;
+
+    // one timer per shard instead of one per socket operation, the wheel does the rest.
+    net::steady_timer timer(co_await net::this_coro::executor);
+    boost::system::error_code ec;
+    while (!stopped_ || sessions.size() != 0) {
+        timer.expires_after(100ms);
+        co_await timer.async_wait(util::net_awaitable[ec]);
+        sessions.expire(std::chrono::steady_clock::now(), revisit_interval());
+    }
+}
+
+std::chrono::steady_clock::duration http_server::impl::revisit_interval() const
+{
+    // every deadline is set at least this far ahead, so moving one never needs the wheel.
+    return std::min({read_timeout_, write_timeout_, keep_alive_timeout_, header_timeout_});
+}
+
+net::awaitable<boost::system::error_code>
+http_server::impl::co_accept(tcp::acceptor& acceptor, session_registry::shard& sessions)
+{
+    auto ex = acceptor.get_executor();
+
     boost::system::error_code ec;
     for (;;) {
-        tcp::socket sock(ex_);
-        co_await acceptor_.async_accept(sock, util::net_awaitable[ec]);
+        bool admitted = limiter_.try_acquire();
+        if (!admitted && !limiter_.reject_on_overload()) {
+            // stop accepting until a connection goes away, the backlog absorbs the burst.
+            co_await limiter_.async_wait_slot();
+            if (!acceptor.is_open())
+                break;
+            continue;
+        }
+
+        tcp::socket sock(ex);
+        co_await acceptor.async_accept(sock, util::net_awaitable[ec]);
         if (ec) {
+            if (admitted)
+                limiter_.release();
             if (ec == boost::system::errc::too_many_files_open ||
                 ec == boost::system::errc::too_many_files_open_in_system)
             {
                 ec = {};
                 using namespace std::chrono_literals;
-                net::steady_timer retry_timer(ex_);
+                net::steady_timer retry_timer(ex);
                 retry_timer.expires_after(100ms);
                 co_await retry_timer.async_wait(util::net_awaitable[ec]);
                 if (!ec)
@@ -119,23 +418,36 @@ net::awaitable<boost::system::error_code> http_server::impl::co_accept()
             }
             break;
         }
-        net::co_spawn(ex_, handle_accept(std::move(sock)), net::detached);
+        // a session runs on its own strand, deadlines and shutdown post their abort to it.
+        net::co_spawn(net::make_strand(ex),
+                      handle_accept(std::move(sock), sessions, admitted),
+                      net::detached);
     }
     get_logger()->trace("async_accept: {}", ec.message());
     co_return ec;
 }
-net::awaitable<void> http_server::impl::handle_accept(tcp::socket sock)
+net::awaitable<void> http_server::impl::handle_accept(tcp::socket sock,
+                                                     session_registry::shard& sessions,
+                                                     bool admitted)
 {
-    auto remote_endp = sock.remote_endpoint();
-    auto local_endp  = sock.local_endpoint();
+    boost::system::error_code ec;
+    auto remote_endp = sock.remote_endpoint(ec);
     get_logger()->trace(
         "accept new connection [{}:{}]", remote_endp.address().to_string(), remote_endp.port());
 
-    auto conn = std::make_shared<session>(std::move(sock), *this);
-    {
-        std::lock_guard lck(session_mutex_);
-        session_map_.insert(conn);
+    if (!admitted || !limiter_.try_acquire_address(remote_endp.address())) {
+        get_logger()->debug("reject connection [{}:{}]: too many connections",
+                            remote_endp.address().to_string(),
+                            remote_endp.port());
+        if (admitted)
+            limiter_.release();
+        reject_connection(sock);
+        co_return;
     }
+
+    auto executor = co_await net::this_coro::executor;
+    auto conn     = std::make_shared<session>(std::move(sock), *this, executor);
+    sessions.insert(*conn);
     try {
         co_await conn->run();
     }
@@ -145,14 +457,32 @@ net::awaitable<void> http_server::impl::handle_accept(tcp::socket sock)
     catch (...) {
         get_logger()->error("session::run() unknown exception");
     }
-    {
-        std::lock_guard lck(session_mutex_);
-        session_map_.erase(conn);
-    }
+    sessions.erase(*conn);
+    conn.reset();
+
+    limiter_.release_address(remote_endp.address());
+    limiter_.release();
     get_logger()->trace(
         "close connection [{}:{}]", remote_endp.address().to_string(), remote_endp.port());
 }
 
+void http_server::impl::reject_connection(tcp::socket& sock)
+{
+    static constexpr std::string_view overload_response = "HTTP/1.1 503 Service Unavailable\r\n"
+                                                          "Connection: close\r\n"
+                                                          "Content-Length: 0\r\n"
+                                                          "Retry-After: 1\r\n"
+                                                          "\r\n";
+    boost::system::error_code ec;
+    if (limiter_.reject_on_overload()) {
+        // best effort: a fresh socket send buffer always takes these few bytes at once.
+        sock.non_blocking(true, ec);
+        sock.write_some(net::buffer(overload_response), ec);
+    }
+    sock.shutdown(net::socket_base::shutdown_both, ec);
+    sock.close(ec);
+}
+
 void http_server::impl::set_read_timeout(const std::chrono::steady_clock::duration& dur)
 {
     read_timeout_ = dur;
@@ -163,6 +493,16 @@ void http_server::impl::set_write_timeout(const std::chrono::steady_clock::durat
     write_timeout_ = dur;
 }
 
+void http_server::impl::set_keep_alive_timeout(const std::chrono::steady_clock::duration& dur)
+{
+    keep_alive_timeout_ = dur;
+}
+
+void http_server::impl::set_header_timeout(const std::chrono::steady_clock::duration& dur)
+{
+    header_timeout_ = dur;
+}
+
 const std::chrono::steady_clock::duration& http_server::impl::read_timeout() const
 {
     return read_timeout_;
@@ -173,9 +513,53 @@ const std::chrono::steady_clock::duration& http_server::impl::write_timeout() co
     return write_timeout_;
 }
 
+void http_server::impl::set_http2_max_concurrent_streams(std::uint32_t count)
+{
+    http2_max_concurrent_streams_ = count;
+}
+
+std::uint32_t http_server::impl::http2_max_concurrent_streams() const
+{
+    return http2_max_concurrent_streams_;
+}
+
+void http_server::impl::prepare_body(body_mode mode, http::request<body::any_body>& req) const
+{
+    if (mode == body_mode::file) {
+        body::file_body::value_type value;
+        value.upload            = std::make_shared<body::file_body::upload_file>();
+        value.upload->directory = upload_directory_;
+        value.upload->direct_io = upload_direct_io_;
+        value.upload->limit     = upload_limit_;
+        req.body()              = std::move(value);
+    }
+    else if (form_data_spill_size_ != 0 &&
+             detail::is_multipart_form_data(req[http::field::content_type]))
+    {
+        html::form_data value;
+        value.spill_size      = form_data_spill_size_;
+        value.spill_directory = upload_directory_;
+        value.spill_limit     = upload_limit_;
+        value.spill_direct_io = upload_direct_io_;
+        req.body()            = std::move(value);
+    }
+}
+
+const std::chrono::steady_clock::duration& http_server::impl::keep_alive_timeout() const
+{
+    return keep_alive_timeout_;
+}
+
+const std::chrono::steady_clock::duration& http_server::impl::header_timeout() const
+{
+    return header_timeout_;
+}
+
 tcp::endpoint http_server::impl::local_endpoint() const
 {
     boost::system::error_code ec;
+    if (!shards_.empty())
+        return shards_.front()->acceptor.local_endpoint(ec);
     return acceptor_.local_endpoint(ec);
 }
 
@@ -191,6 +575,16 @@ void http_server::impl::set_logger(std::shared_ptr<spdlog::logger> logger)
     custom_logger_ = logger;
 }
 
+void http_server::impl::set_access_log(const fs::path& file, access_log_format format)
+{
+    access_log_ = std::make_unique<server::access_log>(file, format);
+}
+
+std::uint64_t http_server::impl::access_log_dropped() const
+{
+    return access_log_ ? access_log_->dropped() : 0;
+}
+
 void http_server::impl::use_ssl(const net::const_buffer& cert_file,
                                 const net::const_buffer& key_file,
                                 std::string passwd /*= {}*/)
@@ -211,6 +605,28 @@ void http_server::impl::use_ssl(const net::const_buffer& cert_file,
     }
     ssl_ctx->use_certificate(cert_file, ssl::context_base::pem);
     ssl_ctx->use_rsa_private_key(key_file, ssl::context::pem);
+#ifdef HTTPLIB_ENABLED_HTTP2
+    // ALPN: offer h2 first, anything else stays on HTTP/1.1.
+    SSL_CTX_set_alpn_select_cb(
+        ssl_ctx->native_handle(),
+        [](SSL*,
+           const unsigned char** out,
+           unsigned char* outlen,
+           const unsigned char* in,
+           unsigned int inlen,
+           void*) -> int {
+            static constexpr unsigned char protos[] = "\x02h2\x08http/1.1";
+            if (SSL_select_next_proto(const_cast<unsigned char**>(out),
+                                      outlen,
+                                      protos,
+                                      sizeof(protos) - 1,
+                                      in,
+                                      inlen) != OPENSSL_NPN_NEGOTIATED)
+                return SSL_TLSEXT_ERR_NOACK;
+            return SSL_TLSEXT_ERR_OK;
+        },
+        nullptr);
+#endif
 
     ssl_context_ = ssl_ctx;
 #else
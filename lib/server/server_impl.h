@@ -1,10 +1,16 @@
 #pragma once
 #include "httplib/server/router.hpp"
+#include "access_log.hpp"
+#include "connection_limiter.hpp"
 #include "httplib/server/server.hpp"
 #include "router_impl.h"
 #include "session.hpp"
+#include "session_registry.hpp"
+#include "util/striped_counter.hpp"
 #include <boost/asio/co_spawn.hpp>
 #include <boost/asio/detached.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/asio/thread_pool.hpp>
 #include <functional>
@@ -13,14 +19,14 @@
 #include <memory>
 #include <span>
 #include <spdlog/spdlog.h>
-#include <unordered_set>
+#include <thread>
 
 namespace httplib::server {
 class http_server::impl : public std::enable_shared_from_this<impl>
 {
 public:
     explicit impl(const net::any_io_executor& ex);
-    ~impl() = default;
+    ~impl();
 
 public:
     net::any_io_executor get_executor() noexcept;
@@ -29,23 +35,66 @@ public:
                 uint16_t port,
                 int backlog = net::socket_base::max_listen_connections);
 
+    void set_reuse_port_shards(std::size_t count);
+    std::size_t reuse_port_shards() const;
+
     void async_run();
     net::awaitable<boost::system::error_code> co_run();
 
     void stop();
+    net::awaitable<bool> async_drain(const std::chrono::steady_clock::duration& timeout);
+    bool draining() const;
     router_impl& router();
 
+    std::size_t connection_count() const;
+
+    connection_limiter& limiter() { return limiter_; }
+
+    std::size_t in_flight_requests() const;
+    void request_started() { in_flight_.increment(); }
+    // wakes async_drain() up while it waits.
+    void request_finished();
+
     void set_read_timeout(const std::chrono::steady_clock::duration& dur);
     void set_write_timeout(const std::chrono::steady_clock::duration& dur);
+    void set_keep_alive_timeout(const std::chrono::steady_clock::duration& dur);
+    void set_header_timeout(const std::chrono::steady_clock::duration& dur);
 
     const std::chrono::steady_clock::duration& read_timeout() const;
     const std::chrono::steady_clock::duration& write_timeout() const;
+    const std::chrono::steady_clock::duration& keep_alive_timeout() const;
+    const std::chrono::steady_clock::duration& header_timeout() const;
+
+    void set_http2_max_concurrent_streams(std::uint32_t count);
+    std::uint32_t http2_max_concurrent_streams() const;
+
+    void set_compression_policy(compression_policy policy)
+    {
+        compression_policy_ = std::move(policy);
+    }
+    const compression_policy& get_compression_policy() const { return compression_policy_; }
+
+    void set_upload_directory(const fs::path& dir) { upload_directory_ = dir; }
+    const fs::path& upload_directory() const { return upload_directory_; }
+    void set_upload_direct_io(bool enabled) { upload_direct_io_ = enabled; }
+    bool upload_direct_io() const { return upload_direct_io_; }
+    void set_upload_limit(std::uint64_t bytes) { upload_limit_ = bytes; }
+    std::uint64_t upload_limit() const { return upload_limit_; }
+    void set_form_data_spill_size(std::size_t bytes) { form_data_spill_size_ = bytes; }
+    std::size_t form_data_spill_size() const { return form_data_spill_size_; }
+    // sets the body a request is read into before it is read: the upload file of a
+    // body_mode::file route, the spill settings of a multipart form.
+    void prepare_body(body_mode mode, http::request<body::any_body>& req) const;
 
     tcp::endpoint local_endpoint() const;
 
     std::shared_ptr<spdlog::logger> get_logger() const;
     void set_logger(std::shared_ptr<spdlog::logger> logger);
 
+    void set_access_log(const fs::path& file, access_log_format format);
+    server::access_log* get_access_log() const { return access_log_.get(); }
+    std::uint64_t access_log_dropped() const;
+
     void use_ssl(const net::const_buffer& cert_file,
                  const net::const_buffer& key_file,
                  std::string passwd = {});
@@ -54,23 +103,75 @@ public:
 #endif
 
 private:
-    net::awaitable<boost::system::error_code> co_accept();
-    net::awaitable<void> handle_accept(tcp::socket sock);
+    struct io_shard
+    {
+        explicit io_shard(std::size_t index);
+
+        std::size_t index;
+        net::io_context ioc;
+        tcp::acceptor acceptor;
+        std::optional<net::executor_work_guard<net::io_context::executor_type>> work;
+        std::thread thread;
+    };
+
+    void stop_accept();
+    net::awaitable<boost::system::error_code> co_run_shards();
+    void start_shard_threads();
+
+    // drives the deadlines of one registry shard, on the executor its sessions live on.
+    net::awaitable<void> co_expire(session_registry::shard& sessions);
+    std::chrono::steady_clock::duration revisit_interval() const;
+
+    net::awaitable<boost::system::error_code> co_accept(tcp::acceptor& acceptor,
+                                                        session_registry::shard& sessions);
+    net::awaitable<void>
+    handle_accept(tcp::socket sock, session_registry::shard& sessions, bool admitted);
+    void reject_connection(tcp::socket& sock);
 
 private:
     net::any_io_executor ex_;
 
     router_impl router_;
     tcp::acceptor acceptor_;
-
-    std::mutex session_mutex_;
-    std::unordered_set<std::shared_ptr<session>> session_map_;
-
-    std::chrono::steady_clock::duration read_timeout_  = std::chrono::seconds(30);
-    std::chrono::steady_clock::duration write_timeout_ = std::chrono::seconds(30);
+    session_registry sessions_;
+    connection_limiter limiter_;
+
+    std::atomic_bool draining_ = false;
+    std::atomic_bool stopped_  = false;
+    util::striped_counter in_flight_;
+
+    struct drain_waiter
+    {
+        explicit drain_waiter(net::strand<net::any_io_executor> strand)
+            : strand(strand)
+            , timer(strand)
+        {
+        }
+
+        net::strand<net::any_io_executor> strand;
+        net::steady_timer timer;
+        bool woken = false;
+    };
+    std::mutex drain_mutex_;
+    std::shared_ptr<drain_waiter> drain_waiter_;
+
+    std::size_t shard_count_ = 0;
+    std::vector<std::unique_ptr<io_shard>> shards_;
+
+    std::chrono::steady_clock::duration read_timeout_       = std::chrono::seconds(30);
+    std::chrono::steady_clock::duration write_timeout_      = std::chrono::seconds(30);
+    std::chrono::steady_clock::duration keep_alive_timeout_ = std::chrono::seconds(30);
+    std::chrono::steady_clock::duration header_timeout_     = std::chrono::seconds(30);
+    std::uint32_t http2_max_concurrent_streams_             = 100;
+    compression_policy compression_policy_;
+    fs::path upload_directory_;
+    bool upload_direct_io_            = false;
+    std::uint64_t upload_limit_       = std::uint64_t(1) << 30;
+    std::size_t form_data_spill_size_ = 0;
 
     std::shared_ptr<spdlog::logger> default_logger_;
     std::shared_ptr<spdlog::logger> custom_logger_;
+    std::unique_ptr<server::access_log> access_log_;
 
 #ifdef HTTPLIB_ENABLED_SSL
     std::shared_ptr<ssl::context> ssl_context_;
@@ -80,4 +181,27 @@ private:
     friend class session;
 };
 
+namespace detail {
+
+// one request in flight for async_drain, from its header on until its response is done; also
+// when the coroutine serving it throws or is destroyed.
+class in_flight_scope
+{
+public:
+    explicit in_flight_scope(http_server::impl& serv)
+        : serv_(serv)
+    {
+        serv_.request_started();
+    }
+    ~in_flight_scope() { serv_.request_finished(); }
+
+private:
+    in_flight_scope(const in_flight_scope&)            = delete;
+    in_flight_scope& operator=(const in_flight_scope&) = delete;
+
+    http_server::impl& serv_;
+};
+
+} // namespace detail
+
 } // namespace httplib::server
\ No newline at end of file
@@ -1,20 +1,33 @@
 #include "session.hpp"
 #include "body/compressor.hpp"
-#include "httplib/html/accept_content.hpp"
+#include "compression.hpp"
+#include "file_reader.hpp"
 #include "httplib/server/response.hpp"
 #include "httplib/server/router.hpp"
 #include "httplib/server/server.hpp"
+#include "access_log.hpp"
+#include "http2_connection.hpp"
 #include "websocket_conn_impl.hpp"
 #include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/asio/post.hpp>
 #include <boost/asio/write.hpp>
+#include <boost/beast/core/detail/base64.hpp>
 #include <boost/beast/core/detect_ssl.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/core/read_size.hpp>
+#include <boost/beast/http/buffer_body.hpp>
 #include <boost/beast/http/empty_body.hpp>
 #include <boost/beast/http/parser.hpp>
 #include <boost/beast/http/read.hpp>
 #include <boost/beast/http/serializer.hpp>
+#include <boost/beast/http/write.hpp>
 #include <boost/beast/websocket/rfc6455.hpp>
+#include <charconv>
 
+#ifdef __linux__
+#include <cerrno>
+#include <sys/sendfile.h>
+#endif
 
 namespace httplib::server {
 
@@ -47,8 +60,116 @@ net::awaitable<void> transfer(S1& from, S2& to, size_t& bytes_transferred)
     }
 }
 
+// the body of a streamed request, read from the connection as the handler asks for it.
+class streamed_body : public request::body_stream
+{
+public:
+    streamed_body(http::request_parser<http::empty_body>&& header_parser,
+                  http_stream& stream,
+                  beast::flat_buffer& buffer,
+                  util::timer_wheel::entry& deadline,
+                  std::chrono::steady_clock::duration timeout)
+        : parser_(std::move(header_parser))
+        , stream_(stream)
+        , buffer_(buffer)
+        , deadline_(deadline)
+        , timeout_(timeout)
+    {
+    }
+
+    net::awaitable<std::size_t> async_read_some(net::mutable_buffer buffer,
+                                                boost::system::error_code& ec) override
+    {
+        ec = {};
+        if (buffer.size() == 0 || parser_.is_done())
+            co_return 0;
+
+        auto& body = parser_.get().body();
+        for (;;) {
+            body.data = buffer.data();
+            body.size = buffer.size();
+            body.more = true;
+
+            deadline_.expires_after(timeout_);
+            co_await http::async_read_some(stream_, buffer_, parser_, util::net_awaitable[ec]);
+            deadline_.expires_never();
+            if (ec == http::error::need_buffer)
+                ec = {};
+            if (ec)
+                co_return 0;
+
+            // chunk headers alone do not fill anything, go on until data or the end.
+            auto bytes = buffer.size() - body.size;
+            if (bytes != 0 || parser_.is_done())
+                co_return bytes;
+        }
+    }
+    bool is_done() const override { return parser_.is_done(); }
+
+private:
+    http::request_parser<http::buffer_body> parser_;
+    http_stream& stream_;
+    beast::flat_buffer& buffer_;
+    util::timer_wheel::entry& deadline_;
+    std::chrono::steady_clock::duration timeout_;
+};
+
+#ifdef HTTPLIB_ENABLED_HTTP2
+// HTTP2-Settings is base64url without padding.
+static std::string decode_http2_settings(std::string_view value)
+{
+    std::string base64(value);
+    for (auto& c : base64) {
+        if (c == '-')
+            c = '+';
+        else if (c == '_')
+            c = '/';
+    }
+    base64.append((4 - base64.size() % 4) % 4, '=');
+
+    std::string settings(beast::detail::base64::decoded_size(base64.size()), '\0');
+    auto [written, read] =
+        beast::detail::base64::decode(settings.data(), base64.data(), base64.size());
+    if (read != base64.size())
+        return {};
+    settings.resize(written);
+    return settings;
+}
+
+static constexpr std::string_view http2_preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+// whether what was read so far is the h2c client preface, or the start of it.
+static bool starts_http2_preface(const beast::flat_buffer& buffer)
+{
+    auto data = std::string_view(static_cast<const char*>(buffer.data().data()), buffer.size());
+    return http2_preface.starts_with(data.substr(0, http2_preface.size()));
+}
+#endif
+
 } // namespace detail
 
+#ifdef HTTPLIB_ENABLED_HTTP2
+class session::http2_task : public session::task
+{
+public:
+    explicit http2_task(std::shared_ptr<http2_connection> conn)
+        : conn_(std::move(conn))
+    {
+    }
+
+    net::awaitable<task::ptr> then() override
+    {
+        co_await conn_->run();
+        co_return nullptr;
+    }
+
+    void abort() override { conn_->close(); }
+    void drain() override { conn_->drain(); }
+
+private:
+    std::shared_ptr<http2_connection> conn_;
+};
+#endif
 
 #ifdef HTTPLIB_ENABLED_SSL
 class session::ssl_handshake_task : public session::task
@@ -56,8 +177,10 @@ class session::ssl_handshake_task : public session::task
 public:
     explicit ssl_handshake_task(http_stream::tls_stream&& stream,
                                 beast::flat_buffer&& buffer,
+                                session& sess,
                                 http_server::impl& serv)
-        : serv_(serv)
+        : session_(sess)
+        , serv_(serv)
         , stream_(std::move(stream))
         , buffer_(std::move(buffer))
     {
@@ -67,32 +190,44 @@ public:
     net::awaitable<task::ptr> then() override
     {
         boost::system::error_code ec;
-        beast::get_lowest_layer(stream_).expires_after(serv_.read_timeout());
+        session_.expires_after(serv_.header_timeout());
         auto bytes_used = co_await stream_.async_handshake(
             ssl::stream_base::server, buffer_.data(), util::net_awaitable[ec]);
-        beast::get_lowest_layer(stream_).expires_never();
         if (ec) {
             serv_.get_logger()->trace("ssl handshake failed: {}", ec.message());
             co_return nullptr;
         }
         buffer_.consume(bytes_used);
 
+#ifdef HTTPLIB_ENABLED_HTTP2
+        const unsigned char* alpn = nullptr;
+        unsigned int alpn_size    = 0;
+        SSL_get0_alpn_selected(stream_.native_handle(), &alpn, &alpn_size);
+        if (std::string_view(reinterpret_cast<const char*>(alpn), alpn_size) == "h2") {
+            co_return std::make_unique<http2_task>(std::make_shared<http2_connection>(
+                serv_, http_stream(std::move(stream_)), std::move(buffer_), session_));
+        }
+#endif
+
         http_stream variant_stream(std::move(stream_));
-        co_return std::make_unique<http_task>(std::move(variant_stream), std::move(buffer_), serv_);
+        co_return std::make_unique<http_task>(
+            std::move(variant_stream), std::move(buffer_), session_, serv_);
     }
 
 
     void abort() override { stream_.shutdown(); }
 
 private:
+    session& session_;
     http_server::impl& serv_;
     http_stream::tls_stream stream_;
     beast::flat_buffer buffer_;
 };
 #endif
 
-session::session(tcp::socket&& stream, http_server::impl& serv)
-    : task_(std::make_unique<detect_ssl_task>(std::move(stream), serv))
+session::session(tcp::socket&& stream, http_server::impl& serv, net::any_io_executor executor)
+    : executor_(std::move(executor))
+    , task_(std::make_unique<detect_ssl_task>(std::move(stream), *this, serv))
 {
 }
 
@@ -102,13 +237,25 @@ session::~session()
 
 void session::abort()
 {
-    if (abort_)
+    if (abort_.exchange(true))
         return;
-    abort_ = true;
 
-    std::lock_guard<std::mutex> lck(task_mtx_);
-    if (task_)
-        task_->abort();
+    // the registry calls in under its lock, from whichever thread runs the deadline or stop();
+    // the sockets are only closed on the strand the session's coroutine runs on.
+    net::post(executor_, [self = shared_from_this()]() {
+        std::lock_guard<std::mutex> lck(self->task_mtx_);
+        if (self->task_)
+            self->task_->abort();
+    });
+}
+
+void session::drain()
+{
+    net::post(executor_, [self = shared_from_this()]() {
+        std::lock_guard<std::mutex> lck(self->task_mtx_);
+        if (self->task_)
+            self->task_->drain();
+    });
 }
 
 httplib::net::awaitable<void> session::run()
@@ -121,8 +268,11 @@ httplib::net::awaitable<void> session::run()
     co_return;
 }
 
-session::detect_ssl_task::detect_ssl_task(tcp::socket&& stream, http_server::impl& serv)
-    : serv_(serv)
+session::detect_ssl_task::detect_ssl_task(tcp::socket&& stream,
+                                          session& sess,
+                                          http_server::impl& serv)
+    : session_(sess)
+    , serv_(serv)
     , stream_(std::move(stream))
 {
 }
@@ -135,21 +285,23 @@ net::awaitable<session::task::ptr> session::detect_ssl_task::then()
 #ifdef HTTPLIB_ENABLED_SSL
     if (auto ssl_ctx = serv_.ssl_context(); ssl_ctx) {
         boost::system::error_code ec;
-        stream_.expires_after(serv_.read_timeout());
+        session_.expires_after(serv_.header_timeout());
         bool is_ssl = co_await beast::async_detect_ssl(stream_, buffer, util::net_awaitable[ec]);
-        stream_.expires_never();
         if (ec) {
             serv_.get_logger()->trace("async_detect_ssl failed: {}", ec.message());
             co_return nullptr;
         }
         if (is_ssl) {
             co_return std::make_unique<session::ssl_handshake_task>(
-                http_stream::tls_stream(std::move(stream_), ssl_ctx), std::move(buffer), serv_);
+                http_stream::tls_stream(std::move(stream_), ssl_ctx),
+                std::move(buffer),
+                session_,
+                serv_);
         }
     }
 #endif
     co_return std::make_unique<session::http_task>(
-        http_stream(std::move(stream_)), std::move(buffer), serv_);
+        http_stream(std::move(stream_)), std::move(buffer), session_, serv_);
 }
 void session::detect_ssl_task::abort()
 {
@@ -158,8 +310,10 @@ void session::detect_ssl_task::abort()
 
 session::http_task::http_task(http_stream&& stream,
                               beast::flat_buffer&& buffer,
+                              session& sess,
                               http_server::impl& serv)
-    : serv_(serv)
+    : session_(sess)
+    , serv_(serv)
     , buffer_(std::move(buffer))
     , stream_(std::move(stream))
 {
@@ -180,21 +334,113 @@ net::awaitable<session::task::ptr> session::http_task::then()
                                        local_endp.address().to_string(),
                                        local_endp.port());
 
+    auto* access_log = serv_.get_access_log();
+
     for (;;) {
+        // publish idle before looking at the drain flag, async_drain() does it the other way
+        // round, so one of us always sees the other. Not idle while responses are pending.
+        idle_ = pending_.size() == 0;
+        if (serv_.draining()) {
+            co_await flush_pending();
+            co_return nullptr;
+        }
+
         http::request_parser<http::empty_body> header_parser;
         header_parser.header_limit(std::numeric_limits<std::uint32_t>::max());
         header_parser.body_limit(std::numeric_limits<unsigned long long>::max());
 
-        stream_.expires_after(serv_.read_timeout());
+        if (buffer_.size() == 0) {
+            if (!co_await flush_pending())
+                co_return nullptr;
+
+            // keep-alive: nothing of the next request has arrived yet.
+            session_.expires_after(serv_.keep_alive_timeout());
+            auto bytes = co_await stream_.async_read_some(
+                buffer_.prepare(beast::read_size(buffer_, 64 * 1024)), util::net_awaitable[ec]);
+            if (ec) {
+                serv_.get_logger()->trace("wait http request failed: {}", ec.message());
+                co_return nullptr;
+            }
+            buffer_.commit(bytes);
+        }
+
+        session_.expires_after(serv_.header_timeout());
+#ifdef HTTPLIB_ENABLED_HTTP2
+        // h2c with prior knowledge: beast only parses HTTP/1.x, so the client preface is told
+        // apart here and handed to nghttp2 as it came.
+        if (!stream_.is_tls() && detail::starts_http2_preface(buffer_)) {
+            while (buffer_.size() < detail::http2_preface.size() &&
+                   detail::starts_http2_preface(buffer_))
+            {
+                auto bytes = co_await stream_.async_read_some(
+                    buffer_.prepare(beast::read_size(buffer_, 64 * 1024)),
+                    util::net_awaitable[ec]);
+                if (ec) {
+                    serv_.get_logger()->trace("read http2 preface failed: {}", ec.message());
+                    co_return nullptr;
+                }
+                buffer_.commit(bytes);
+            }
+            if (detail::starts_http2_preface(buffer_)) {
+                if (!co_await flush_pending())
+                    co_return nullptr;
+                co_return std::make_unique<http2_task>(std::make_shared<http2_connection>(
+                    serv_, std::move(stream_), std::move(buffer_), session_));
+            }
+        }
+#endif
         co_await http::async_read_header(stream_, buffer_, header_parser, util::net_awaitable[ec]);
-        stream_.expires_never();
         if (ec) {
             serv_.get_logger()->trace("read http header failed: {}", ec.message());
             co_return nullptr;
         }
+        detail::in_flight_scope in_flight(serv_);
+        idle_ = false;
+
+        auto received_time = std::chrono::steady_clock::now();
+        bytes_sent_        = 0;
 
         const auto& header = header_parser.get();
 
+#ifdef HTTPLIB_ENABLED_HTTP2
+        // h2c upgrade, only for requests without a body.
+        if (!stream_.is_tls() && header_parser.is_done() &&
+            beast::iequals(header[http::field::upgrade], "h2c") &&
+            header.count("HTTP2-Settings") != 0)
+        {
+            static constexpr std::string_view switching_protocols =
+                "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+
+            auto value    = header["HTTP2-Settings"];
+            auto settings = detail::decode_http2_settings({value.data(), value.size()});
+            if (!co_await flush_pending())
+                co_return nullptr;
+
+            session_.expires_after(serv_.write_timeout());
+            co_await net::async_write(
+                stream_, net::buffer(switching_protocols), util::net_awaitable[ec]);
+            if (ec) {
+                serv_.get_logger()->trace("write switching protocols failed: {}", ec.message());
+                co_return nullptr;
+            }
+
+            request req(local_endp, remote_endp, header_parser.release());
+            auto conn = std::make_shared<http2_connection>(
+                serv_, std::move(stream_), std::move(buffer_), session_);
+            if (!conn->upgrade(std::move(req), settings))
+                co_return nullptr;
+            co_return std::make_unique<http2_task>(std::move(conn));
+        }
+#endif
+
+        if (header.method() == http::verb::connect || websocket::is_upgrade(header.base())) {
+            if (!co_await flush_pending())
+                co_return nullptr;
+        }
+
+        // websocket and tunnels run without a deadline, like the handlers do.
+        session_.expires_never();
+
         // http proxy
         if (header.method() == http::verb::connect) {
             request req(local_endp, remote_endp, std::move(header_parser.release()));
@@ -208,34 +454,64 @@ net::awaitable<session::task::ptr> session::http_task::then()
         }
 
         response resp(header.version(), header.keep_alive());
-        request req(local_endp, remote_endp, http::request<http::empty_body>(header));
+
+        // without a body the parser is already done: move the header out instead of copying it,
+        // no body parser is needed.
+        bool has_body = !header_parser.is_done();
+        request req(local_endp,
+                    remote_endp,
+                    has_body ? http::request<http::empty_body>(header) : header_parser.release());
+
+        // a handler that can wait must not hold back the responses batched before it.
+        if (pending_.size() != 0 && _router.may_suspend(req)) {
+            if (!co_await flush_pending())
+                co_return nullptr;
+        }
 
         auto start_time = std::chrono::steady_clock::now();
 
         try {
             if (co_await _router.pre_routing(req, resp)) {
-                if (beast::iequals(header[http::field::expect], "100-continue")) {
-                    // send 100 response
-                    response resp(header.version(), true);
-                    resp.set_empty_content(http::status::continue_);
-                    if (!co_await async_write(req, resp))
+                if (has_body) {
+                    if (beast::iequals(req[http::field::expect], "100-continue")) {
+                        // send 100 response
+                        response resp(req.version(), true);
+                        resp.set_empty_content(http::status::continue_);
+                        if (!co_await async_write(req, resp))
+                            co_return nullptr;
+                    }
+                    // the body may have to come from the socket, do not sit on responses.
+                    if (!co_await flush_pending())
                         co_return nullptr;
-                }
 
-                http::request_parser<body::any_body> body_parser(std::move(header_parser));
-                while (!body_parser.is_done()) {
-                    stream_.expires_after(serv_.read_timeout());
-                    co_await http::async_read_some(
-                        stream_, buffer_, body_parser, util::net_awaitable[ec]);
-                    if (ec) {
-                        stream_.expires_never();
-                        serv_.get_logger()->trace("read http body failed: {}", ec.message());
-                        co_return nullptr;
+                    auto mode = router_impl::query_body_mode(_router.route(req));
+                    if (mode == body_mode::streamed) {
+                        req.set_body_stream(
+                            std::make_unique<detail::streamed_body>(std::move(header_parser),
+                                                                    stream_,
+                                                                    buffer_,
+                                                                    session_,
+                                                                    serv_.read_timeout()));
+                    }
+                    else {
+                        http::request_parser<body::any_body> body_parser(
+                            std::move(header_parser));
+                        serv_.prepare_body(mode, body_parser.get());
+                        while (!body_parser.is_done()) {
+                            session_.expires_after(serv_.read_timeout());
+                            co_await http::async_read_some(
+                                stream_, buffer_, body_parser, util::net_awaitable[ec]);
+                            if (ec) {
+                                serv_.get_logger()->trace("read http body failed: {}",
+                                                          ec.message());
+                                co_return nullptr;
+                            }
+                        }
+                        session_.expires_never();
+                        req.body() = std::move(body_parser.release().body());
+                        start_time = std::chrono::steady_clock::now();
                     }
                 }
-                stream_.expires_never();
-                req.body() = std::move(body_parser.release().body());
-                start_time = std::chrono::steady_clock::now();
 
                 co_await _router.proc_routing(req, resp);
             }
@@ -254,6 +530,12 @@ net::awaitable<session::task::ptr> session::http_task::then()
                                     http::status::internal_server_error);
         }
 
+        if (serv_.draining())
+            resp.keep_alive(false);
+        // whatever the handler left unread of a streamed body is still on the wire.
+        if (!req.is_body_done())
+            resp.keep_alive(false);
+
         auto span_time = std::chrono::steady_clock::now() - start_time;
 
         serv_.get_logger()->debug(
@@ -265,7 +547,29 @@ net::awaitable<session::task::ptr> session::http_task::then()
             std::chrono::duration_cast<std::chrono::milliseconds>(span_time).count());
 
 
-        if (!co_await async_write(req, resp))
+        bool written = co_await async_write(req, resp);
+        if (access_log) {
+            using namespace std::chrono;
+            auto now = steady_clock::now();
+
+            server::access_log::record rec;
+            rec.time_us = duration_cast<microseconds>(
+                              (system_clock::now() - (now - received_time)).time_since_epoch())
+                              .count();
+            rec.duration_us = static_cast<std::uint32_t>(
+                duration_cast<microseconds>(now - received_time).count());
+            rec.handler_us =
+                static_cast<std::uint32_t>(duration_cast<microseconds>(span_time).count());
+            rec.bytes_sent = bytes_sent_;
+            rec.status     = static_cast<std::uint16_t>(resp.result_int());
+            rec.local_port = local_endp.port();
+            rec.version    = static_cast<std::uint8_t>(req.version());
+            rec.method     = req.method();
+            rec.set_remote(remote_endp);
+            rec.set_target({req.target().data(), req.target().size()});
+            access_log->push(rec);
+        }
+        if (!written)
             co_return nullptr;
 
         if (!resp.keep_alive()) {
@@ -285,6 +589,12 @@ void session::http_task::abort()
     stream_.close();
 }
 
+void session::http_task::drain()
+{
+    if (idle_)
+        abort();
+}
+
 net::awaitable<bool> session::http_task::async_write(const request& req, response& resp)
 {
     if (resp.stream_handler_) {
@@ -294,57 +604,74 @@ net::awaitable<bool> session::http_task::async_write(const request& req, respons
         if (!resp.has_content_length())
             resp.prepare_payload();
 
-        if (auto iter = req.find(http::field::accept_encoding); iter != req.end()) {
-            html::accept_encoding_content encoding_content;
-            if (encoding_content.parse(iter->value())) {
-                if (auto encoding = encoding_content.server_apply_encoding(); !encoding.empty()) {
-                    resp.set(http::field::content_encoding, encoding);
-                    resp.chunked(true);
-                }
-            }
-        }
+        const auto& policy = resp.compression_policy_ ? *resp.compression_policy_
+                                                      : serv_.get_compression_policy();
+        if (co_await async_apply_compression(policy, req, resp) == compression_mode::streamed)
+            resp.chunked(true);
     }
     if (req.method() == http::verb::head)
         resp.reset_content();
 
     boost::system::error_code ec;
+    if (!resp.stream_handler_ && (pending_.size() != 0 || has_pipelined_request())) {
+        if (serialize_pending(resp, ec)) {
+            if (resp.keep_alive() && has_pipelined_request())
+                co_return true;
+            co_return co_await flush_pending();
+        }
+        if (ec)
+            co_return false;
+    }
+    if (!co_await flush_pending())
+        co_return false;
+
+    if (is_plain_file(resp)) {
+#ifdef __linux__
+        if (!stream_.is_tls())
+            co_return co_await async_sendfile(resp);
+#endif
+        co_return co_await async_write_file(resp);
+    }
+
     http::response_serializer<body::any_body> serializer(resp);
     {
         while (!serializer.is_done()) {
-            stream_.expires_after(serv_.write_timeout());
-            co_await http::async_write_some(stream_, serializer, util::net_awaitable[ec]);
+            session_.expires_after(serv_.write_timeout());
+            bytes_sent_ +=
+                co_await http::async_write_some(stream_, serializer, util::net_awaitable[ec]);
             if (ec) {
-                stream_.expires_never();
                 serv_.get_logger()->trace("write http body failed: {}", ec.message());
                 co_return false;
             }
         }
-        stream_.expires_never();
+        session_.expires_never();
     }
 
     if (resp.stream_handler_) {
+        // not buffer_: that holds what the client already sent of the next requests.
+        beast::flat_buffer chunk;
         for (;;) {
-            bool has_more = co_await resp.stream_handler_(buffer_, ec);
+            bool has_more = co_await resp.stream_handler_(chunk, ec);
             if (ec) {
                 serv_.get_logger()->trace("read chunk body failed: {}", ec.message());
                 co_return false;
             }
-            if (buffer_.size() != 0) {
-                http::chunk_body chunk_b(buffer_.data());
-                stream_.expires_after(serv_.write_timeout());
-                co_await net::async_write(stream_, chunk_b, util::net_awaitable[ec]);
-                stream_.expires_never();
+            if (chunk.size() != 0) {
+                http::chunk_body chunk_b(chunk.data());
+                session_.expires_after(serv_.write_timeout());
+                bytes_sent_ += co_await net::async_write(stream_, chunk_b, util::net_awaitable[ec]);
+                session_.expires_never();
                 if (ec) {
                     serv_.get_logger()->trace("write chunk body failed: {}", ec.message());
                     co_return false;
                 }
-                buffer_.consume(buffer_.size());
+                chunk.consume(chunk.size());
             }
             if (!has_more) {
                 http::chunk_last chunk_last;
-                stream_.expires_after(serv_.write_timeout());
-                co_await net::async_write(stream_, chunk_last, util::net_awaitable[ec]);
-                stream_.expires_never();
+                session_.expires_after(serv_.write_timeout());
+                bytes_sent_ +=
+                    co_await net::async_write(stream_, chunk_last, util::net_awaitable[ec]);
                 if (ec) {
                     serv_.get_logger()->trace("write chunk last failed: {}", ec.message());
                     co_return false;
@@ -356,6 +683,221 @@ net::awaitable<bool> session::http_task::async_write(const request& req, respons
     co_return true;
 }
 
+bool session::http_task::is_plain_file(const response& resp)
+{
+    if (resp.stream_handler_ || resp.chunked())
+        return false;
+
+    const auto& content = resp.body();
+    if (!content.is_body_type<body::file_body>())
+        return false;
+
+    // multipart byteranges need the boundaries between the parts, the writer does those.
+    // Content-Encoding is only fine on a file stored encoded.
+    // a file held in memory goes out with its header in one write.
+    const auto& file = content.as<body::file_body>();
+    return file.ranges.size() <= 1 && file.info && !file.info->loaded &&
+           (!file.info->content_encoding.empty() ||
+            resp.find(http::field::content_encoding) == resp.end());
+}
+
+net::awaitable<bool> session::http_task::async_write_file_header(response& resp)
+{
+    boost::system::error_code ec;
+    http::response_serializer<body::any_body> serializer(resp);
+    session_.expires_after(serv_.write_timeout());
+    bytes_sent_ +=
+        co_await http::async_write_header(stream_, serializer, util::net_awaitable[ec]);
+    if (ec) {
+        serv_.get_logger()->trace("write http header failed: {}", ec.message());
+        co_return false;
+    }
+    co_return true;
+}
+
+net::awaitable<bool> session::http_task::async_write_file(response& resp)
+{
+    static constexpr std::size_t chunk_size = 256 * 1024;
+
+    auto& file           = resp.body().as<body::file_body>();
+    std::uint64_t offset = 0;
+    std::uint64_t end    = file.file_size();
+    if (!file.ranges.empty()) {
+        offset = file.ranges.front().first;
+        end    = file.ranges.front().second + 1;
+    }
+
+    if (!co_await async_write_file_header(resp))
+        co_return false;
+
+    // no bigger than the range, and a second one only when there is more than one chunk.
+    auto buffer_size =
+        static_cast<std::size_t>((std::min)(end - offset, std::uint64_t(chunk_size)));
+    file_reader reader(co_await net::this_coro::executor, file.info);
+    std::array<std::unique_ptr<char[]>, 2> buffers;
+    buffers[0] = std::make_unique_for_overwrite<char[]>(buffer_size);
+    if (end - offset > chunk_size)
+        buffers[1] = std::make_unique_for_overwrite<char[]>(buffer_size);
+
+    boost::system::error_code read_ec;
+    boost::system::error_code write_ec;
+    auto read_chunk = [&](std::size_t index, std::uint64_t from) {
+        auto size = static_cast<std::size_t>((std::min)(end - from, std::uint64_t(chunk_size)));
+        return reader.async_read_some_at(from, net::buffer(buffers[index].get(), size), read_ec);
+    };
+
+    // while one buffer is written the next chunk is read into the other.
+    std::size_t current = 0;
+    std::size_t bytes   = offset < end ? co_await read_chunk(current, offset) : 0;
+    while (offset < end) {
+        if (read_ec || bytes == 0) {
+            // the file shrank under us, the promised length can not be sent anymore.
+            serv_.get_logger()->trace("read file failed: {}",
+                                      read_ec ? read_ec.message() : "unexpected end of file");
+            co_return false;
+        }
+
+        auto chunk = net::buffer(buffers[current].get(), bytes);
+        offset += bytes;
+        session_.expires_after(serv_.write_timeout());
+        if (offset < end) {
+            using namespace net::experimental::awaitable_operators;
+            auto [written, next] =
+                co_await (net::async_write(stream_, chunk, util::net_awaitable[write_ec]) &&
+                          read_chunk(current ^ 1, offset));
+            bytes_sent_ += written;
+            bytes = next;
+        }
+        else {
+            bytes_sent_ += co_await net::async_write(stream_, chunk, util::net_awaitable[write_ec]);
+        }
+        if (write_ec) {
+            serv_.get_logger()->trace("write file failed: {}", write_ec.message());
+            co_return false;
+        }
+        current ^= 1;
+    }
+    session_.expires_never();
+    co_return true;
+}
+
+#ifdef __linux__
+net::awaitable<bool> session::http_task::async_sendfile(response& resp)
+{
+    static constexpr std::uint64_t max_chunk_size = 1024 * 1024;
+
+    auto& file           = resp.body().as<body::file_body>();
+    std::uint64_t offset = 0;
+    std::uint64_t end    = file.file_size();
+    if (!file.ranges.empty()) {
+        offset = file.ranges.front().first;
+        end    = file.ranges.front().second + 1;
+    }
+
+    if (!co_await async_write_file_header(resp))
+        co_return false;
+
+    boost::system::error_code ec;
+    auto& socket = stream_.socket();
+    socket.native_non_blocking(true, ec);
+    if (ec) {
+        serv_.get_logger()->trace("set non blocking failed: {}", ec.message());
+        co_return false;
+    }
+
+    while (offset < end) {
+        auto file_offset = static_cast<off_t>(offset);
+        auto count       = static_cast<std::size_t>((std::min)(end - offset, max_chunk_size));
+        auto bytes =
+            ::sendfile(socket.native_handle(), file.native_handle(), &file_offset, count);
+        if (bytes > 0) {
+            offset += bytes;
+            bytes_sent_ += bytes;
+            continue;
+        }
+        if (bytes == 0) {
+            // the file shrank under us, the promised length can not be sent anymore.
+            serv_.get_logger()->trace("sendfile failed: {}", "unexpected end of file");
+            co_return false;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            ec.assign(errno, boost::system::system_category());
+            serv_.get_logger()->trace("sendfile failed: {}", ec.message());
+            co_return false;
+        }
+
+        session_.expires_after(serv_.write_timeout());
+        co_await socket.async_wait(tcp::socket::wait_write, util::net_awaitable[ec]);
+        if (ec) {
+            serv_.get_logger()->trace("wait writable failed: {}", ec.message());
+            co_return false;
+        }
+    }
+    session_.expires_never();
+    co_return true;
+}
+#endif
+
+bool session::http_task::has_pipelined_request() const
+{
+    static constexpr std::string_view header_end = "\r\n\r\n";
+
+    auto data = buffer_.data();
+    return std::string_view(static_cast<const char*>(data.data()), data.size())
+               .find(header_end) != std::string_view::npos;
+}
+
+bool session::http_task::serialize_pending(response& resp, boost::system::error_code& ec)
+{
+    static constexpr std::size_t max_body_size    = 16 * 1024;
+    static constexpr std::size_t max_pending_size = 64 * 1024;
+
+    // only plain small bodies, chunked and compressed ones are written as they are produced.
+    if (resp.chunked() || !resp.has_content_length())
+        return false;
+
+    std::uint64_t body_size = 0;
+    auto value              = resp[http::field::content_length];
+    auto [ptr, err] = std::from_chars(value.data(), value.data() + value.size(), body_size);
+    if (err != std::errc {} || body_size > max_body_size ||
+        pending_.size() + body_size > max_pending_size)
+        return false;
+
+    http::response_serializer<body::any_body> serializer(resp);
+    while (!serializer.is_done()) {
+        serializer.next(ec, [&](boost::system::error_code&, const auto& buffers) {
+            auto bytes = net::buffer_copy(pending_.prepare(net::buffer_size(buffers)), buffers);
+            pending_.commit(bytes);
+            serializer.consume(bytes);
+            bytes_sent_ += bytes;
+        });
+        if (ec) {
+            serv_.get_logger()->trace("serialize http response failed: {}", ec.message());
+            return false;
+        }
+    }
+    return true;
+}
+
+net::awaitable<bool> session::http_task::flush_pending()
+{
+    if (pending_.size() == 0)
+        co_return true;
+
+    boost::system::error_code ec;
+    session_.expires_after(serv_.write_timeout());
+    co_await net::async_write(stream_, pending_.data(), util::net_awaitable[ec]);
+    session_.expires_never();
+    pending_.consume(pending_.size());
+    if (ec) {
+        serv_.get_logger()->trace("write pipelined responses failed: {}", ec.message());
+        co_return false;
+    }
+    co_return true;
+}
+
 session::websocket_task::websocket_task(websocket_stream&& stream,
                                         request&& req,
                                         http_server::impl& serv)
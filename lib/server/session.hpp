@@ -3,8 +3,11 @@
 #include "httplib/server/request.hpp"
 #include "httplib/server/response.hpp"
 #include "httplib/server/server.hpp"
+#include "session_registry.hpp"
 #include "stream/http_stream.hpp"
 #include "stream/websocket_stream.hpp"
+#include "util/timer_wheel.hpp"
+#include <boost/asio/any_io_executor.hpp>
 #include <boost/asio/awaitable.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/beast/core/flat_buffer.hpp>
@@ -15,7 +18,10 @@ namespace httplib::server {
 
 class websocket_conn_impl;
 
-class session : public std::enable_shared_from_this<session>
+class session
+    : public std::enable_shared_from_this<session>
+    , public session_registry::hook
+    , public util::timer_wheel::entry
 {
 public:
     class task
@@ -26,21 +32,31 @@ public:
         virtual ~task()                          = default;
         virtual net::awaitable<task::ptr> then() = 0;
         virtual void abort()                     = 0;
+        // nothing in flight by default, so a graceful drain just closes.
+        virtual void drain() { abort(); }
     };
     class detect_ssl_task;
     class ssl_handshake_task;
+    class http2_task;
     class http_task;
     class http_proxy_task;
     class websocket_task;
 
-    explicit session(tcp::socket&& stream, http_server::impl& serv);
+    // `executor` is the strand run() is spawned on.
+    session(tcp::socket&& stream, http_server::impl& serv, net::any_io_executor executor);
     ~session();
 
 public:
+    // both may be called from any thread, the work is posted to the session's strand.
     void abort();
+    void drain();
     net::awaitable<void> run();
 
 private:
+    void on_expired() override { abort(); }
+
+private:
+    net::any_io_executor executor_;
     task::ptr task_;
 
     std::atomic_bool abort_ = false;
@@ -50,7 +66,7 @@ private:
 class session::detect_ssl_task : public session::task
 {
 public:
-    explicit detect_ssl_task(tcp::socket&& stream, http_server::impl& serv);
+    explicit detect_ssl_task(tcp::socket&& stream, session& sess, http_server::impl& serv);
     ~detect_ssl_task();
 
 public:
@@ -58,6 +74,7 @@ public:
     net::awaitable<task::ptr> then() override;
 
 private:
+    session& session_;
     http_server::impl& serv_;
     http_stream::plain_stream stream_;
 };
@@ -66,19 +83,44 @@ private:
 class session::http_task : public session::task
 {
 public:
-    explicit http_task(http_stream&& stream, beast::flat_buffer&& buffer, http_server::impl& serv);
+    explicit http_task(http_stream&& stream,
+                       beast::flat_buffer&& buffer,
+                       session& sess,
+                       http_server::impl& serv);
 
     net::awaitable<task::ptr> then() override;
     void abort() override;
+    void drain() override;
 
 private:
     net::awaitable<bool> async_write(const request& req, response& resp);
+    // plain uncompressed file responses: the header goes through beast, the content is copied
+    // by the kernel with sendfile() or read off the I/O thread, one chunk ahead of the socket.
+    static bool is_plain_file(const response& resp);
+    net::awaitable<bool> async_write_file_header(response& resp);
+    net::awaitable<bool> async_write_file(response& resp);
+#ifdef __linux__
+    net::awaitable<bool> async_sendfile(response& resp);
+#endif
+
+    // pipelining: small responses are serialized into `pending_` while the next request is
+    // already buffered, and all of them go out in a single write.
+    bool has_pipelined_request() const;
+    bool serialize_pending(response& resp, boost::system::error_code& ec);
+    net::awaitable<bool> flush_pending();
 
 private:
+    session& session_;
     http_server::impl& serv_;
 
     http_stream stream_;
     beast::flat_buffer buffer_;
+    beast::flat_buffer pending_;
+
+    // waiting for the next request, nothing would be lost by closing.
+    std::atomic_bool idle_ = false;
+    // bytes of the current response, headers included.
+    std::uint64_t bytes_sent_ = 0;
 };
 
 class session::websocket_task : public session::task
@@ -102,6 +144,7 @@ public:
 public:
     net::awaitable<task::ptr> then() override;
     void abort() override;
+    void drain() override { }
 
 private:
     http_stream stream_;
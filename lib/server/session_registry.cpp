@@ -0,0 +1,88 @@
+#include "session_registry.hpp"
+#include "session.hpp"
+
+namespace httplib::server {
+
+void session_registry::shard::insert(session& conn)
+{
+    hook& node = conn;
+
+    std::lock_guard lck(mutex_);
+    node.owner_ = this;
+    node.prev_  = nullptr;
+    node.next_  = head_;
+    if (head_)
+        head_->prev_ = &node;
+    head_ = &node;
+    size_.fetch_add(1, std::memory_order_relaxed);
+    wheel_.add(conn);
+}
+
+void session_registry::shard::erase(session& conn)
+{
+    hook& node = conn;
+
+    std::lock_guard lck(mutex_);
+    if (node.owner_ != this)
+        return;
+
+    wheel_.remove(conn);
+
+    if (node.prev_)
+        node.prev_->next_ = node.next_;
+    else
+        head_ = node.next_;
+    if (node.next_)
+        node.next_->prev_ = node.prev_;
+
+    node.prev_  = nullptr;
+    node.next_  = nullptr;
+    node.owner_ = nullptr;
+    size_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void session_registry::shard::abort_all()
+{
+    for_each([](session& conn) { conn.abort(); });
+}
+
+std::size_t session_registry::shard::expire(const util::timer_wheel::time_point& now,
+                                            const util::timer_wheel::duration& revisit_interval)
+{
+    std::lock_guard lck(mutex_);
+    wheel_.set_revisit_interval(revisit_interval);
+    return wheel_.advance(now);
+}
+
+session& session_registry::shard::to_session(hook* node)
+{
+    return static_cast<session&>(*node);
+}
+
+session_registry::session_registry(std::size_t shard_count)
+{
+    resize(shard_count);
+}
+
+void session_registry::resize(std::size_t shard_count)
+{
+    shards_.clear();
+    for (std::size_t i = 0; i < std::max<std::size_t>(shard_count, 1); ++i)
+        shards_.push_back(std::make_unique<shard>());
+}
+
+std::size_t session_registry::size() const
+{
+    std::size_t total = 0;
+    for (const auto& v : shards_)
+        total += v->size();
+    return total;
+}
+
+void session_registry::abort_all()
+{
+    for (auto& v : shards_)
+        v->abort_all();
+}
+
+} // namespace httplib::server
@@ -0,0 +1,81 @@
+#pragma once
+#include "util/timer_wheel.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace httplib::server {
+
+class session;
+
+// Registry of live sessions, split in shards so that accept/close on different threads never
+// meet on the same lock. Sessions are linked intrusively through `session_registry::hook`,
+// the registry never owns them and never touches their reference count.
+// Each shard also keeps the connection deadlines of its sessions in a timer wheel.
+class session_registry
+{
+public:
+    class shard;
+
+    class hook
+    {
+    private:
+        hook* prev_   = nullptr;
+        hook* next_   = nullptr;
+        shard* owner_ = nullptr;
+
+        friend class session_registry;
+        friend class shard;
+    };
+
+    class shard
+    {
+    public:
+        void insert(session& conn);
+        void erase(session& conn);
+        void abort_all();
+
+        // fires the deadlines that passed, expired sessions are aborted.
+        std::size_t expire(const util::timer_wheel::time_point& now,
+                           const util::timer_wheel::duration& revisit_interval);
+
+        std::size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+        template<typename Func>
+        void for_each(Func&& func)
+        {
+            std::lock_guard lck(mutex_);
+            for (auto node = head_; node; node = node->next_)
+                func(to_session(node));
+        }
+
+    private:
+        static session& to_session(hook* node);
+
+        std::mutex mutex_;
+        util::timer_wheel wheel_;
+        hook* head_ = nullptr;
+        std::atomic_size_t size_ = 0;
+    };
+
+public:
+    explicit session_registry(std::size_t shard_count);
+
+    // must not be called while sessions are registered.
+    void resize(std::size_t shard_count);
+
+    shard& at(std::size_t index) { return *shards_[index % shards_.size()]; }
+    std::size_t shard_count() const { return shards_.size(); }
+
+    std::size_t size() const;
+    void abort_all();
+
+private:
+    session_registry(const session_registry&)            = delete;
+    session_registry& operator=(const session_registry&) = delete;
+
+    std::vector<std::unique_ptr<shard>> shards_;
+};
+
+} // namespace httplib::server
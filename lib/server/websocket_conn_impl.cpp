@@ -13,7 +13,7 @@ websocket_conn_impl::websocket_conn_impl(http_server::impl& serv,
     : serv_(serv)
     , req_(std::move(req))
     , ws_(std::move(stream))
-    , ac_que_(serv.get_executor())
+    , ac_que_(ws_.socket().get_executor())
 {
 }
 websocket_conn_impl::~websocket_conn_impl()
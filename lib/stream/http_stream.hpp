@@ -58,6 +58,7 @@ public:
     }
 
     bool is_open() const { return socket().is_open(); }
+    bool is_tls() const noexcept { return stream_.index() != 0; }
 
     void expires_after(const net::steady_timer::duration& expiry_time)
     {
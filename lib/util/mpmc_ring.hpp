@@ -0,0 +1,93 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace httplib::util {
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Every cell carries a sequence
+// number telling whose turn it is, so a push or pop is one CAS on the shared position plus a
+// store on the cell. Neither side ever waits: try_push fails when full, try_pop when empty.
+template<typename T>
+class mpmc_ring
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+    explicit mpmc_ring(std::size_t capacity)
+        : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+        , cells_(std::make_unique<cell[]>(mask_ + 1))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    bool try_push(const T& value) noexcept
+    {
+        auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& c  = cells_[pos & mask_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            auto dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = value;
+                    c.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value) noexcept
+    {
+        auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            auto& c  = cells_[pos & mask_];
+            auto seq = c.sequence.load(std::memory_order_acquire);
+            auto dif = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = c.value;
+                    c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    mpmc_ring(const mpmc_ring&)            = delete;
+    mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+    struct cell
+    {
+        std::atomic_size_t sequence;
+        T value;
+    };
+
+    std::size_t mask_;
+    std::unique_ptr<cell[]> cells_;
+
+    alignas(64) std::atomic_size_t enqueue_pos_ = 0;
+    alignas(64) std::atomic_size_t dequeue_pos_ = 0;
+};
+
+} // namespace httplib::util
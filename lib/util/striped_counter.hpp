@@ -0,0 +1,47 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace httplib::util {
+
+// Counter split in cache line sized slots, every thread updates its own slot so that hot
+// increments from many I/O threads never bounce the same line. Reading sums all slots.
+class striped_counter
+{
+public:
+    void add(std::ptrdiff_t value) noexcept
+    {
+        slots_[slot_index()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+    void increment() noexcept { add(1); }
+    void decrement() noexcept { add(-1); }
+
+    std::ptrdiff_t load() const noexcept
+    {
+        std::ptrdiff_t total = 0;
+        for (const auto& v : slots_)
+            total += v.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    static constexpr std::size_t slot_count = 64;
+
+    struct alignas(64) slot
+    {
+        std::atomic<std::ptrdiff_t> value = 0;
+    };
+
+    static std::size_t slot_index() noexcept
+    {
+        static std::atomic_size_t next_index = 0;
+        thread_local std::size_t index =
+            next_index.fetch_add(1, std::memory_order_relaxed) % slot_count;
+        return index;
+    }
+
+    std::array<slot, slot_count> slots_;
+};
+
+} // namespace httplib::util
@@ -0,0 +1,230 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace httplib::util {
+
+// Hierarchical timer wheel for connection deadlines.
+//
+// Entries are linked intrusively. Moving a deadline is a single relaxed store on the entry, the
+// wheel notices it lazily: an entry is never parked further away than `revisit_interval`, so as
+// long as every deadline is set at least `revisit_interval` into the future, touching it never
+// has to relink the entry. Expired entries are unlinked before `on_expired()` runs.
+//
+// The wheel itself is not thread safe, the owner serialises add/remove/advance.
+class timer_wheel
+{
+public:
+    using clock      = std::chrono::steady_clock;
+    using time_point = clock::time_point;
+    using duration   = clock::duration;
+
+    class entry
+    {
+    public:
+        virtual ~entry() = default;
+
+        void expires_at(const time_point& expiry_time) noexcept
+        {
+            deadline_.store(expiry_time.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+        void expires_after(const duration& expiry_time) noexcept
+        {
+            expires_at(clock::now() + expiry_time);
+        }
+        void expires_never() noexcept { deadline_.store(never, std::memory_order_relaxed); }
+
+        time_point expiry() const noexcept
+        {
+            return time_point(duration(deadline_.load(std::memory_order_relaxed)));
+        }
+
+    protected:
+        virtual void on_expired() = 0;
+
+    private:
+        static constexpr duration::rep never = (std::numeric_limits<duration::rep>::max)();
+
+        std::atomic<duration::rep> deadline_ = never;
+
+        entry* prev_        = nullptr;
+        entry* next_        = nullptr;
+        entry** slot_       = nullptr;
+        std::uint64_t tick_ = 0;
+
+        friend class timer_wheel;
+    };
+
+public:
+    explicit timer_wheel(const duration& tick = std::chrono::milliseconds(100))
+        : tick_(tick)
+        , revisit_(std::chrono::seconds(1))
+        , origin_(clock::now())
+    {
+    }
+
+    const duration& tick() const noexcept { return tick_; }
+    std::size_t size() const noexcept { return size_; }
+
+    void set_revisit_interval(const duration& interval) noexcept
+    {
+        revisit_ = (std::max)(interval, tick_);
+    }
+
+    void add(entry& e)
+    {
+        if (e.slot_)
+            return;
+        schedule(e, clock::now());
+        ++size_;
+    }
+
+    void remove(entry& e) noexcept
+    {
+        if (!e.slot_)
+            return;
+        unlink(e);
+        --size_;
+    }
+
+    // Walks every tick up to `now`, fires what expired and re-parks what was only revisited.
+    std::size_t advance(const time_point& now)
+    {
+        std::size_t fired = 0;
+        auto target       = elapsed_ticks(now);
+        while (current_ < target) {
+            ++current_;
+            if ((current_ & level0_mask) == 0)
+                cascade(1);
+
+            auto& head  = level0_[current_ & level0_mask];
+            entry* list = head;
+            head        = nullptr;
+
+            while (list) {
+                entry& e = *list;
+                list     = e.next_;
+                e.prev_  = nullptr;
+                e.next_  = nullptr;
+                e.slot_  = nullptr;
+
+                if (e.expiry() <= now) {
+                    --size_;
+                    ++fired;
+                    e.on_expired();
+                }
+                else {
+                    schedule(e, now);
+                }
+            }
+        }
+        return fired;
+    }
+
+private:
+    timer_wheel(const timer_wheel&)            = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    static constexpr std::size_t level0_bits = 8;
+    static constexpr std::size_t level_bits  = 6;
+    static constexpr std::size_t levels      = 4;
+
+    static constexpr std::uint64_t level0_mask = (1u << level0_bits) - 1;
+    static constexpr std::uint64_t level_mask  = (1u << level_bits) - 1;
+
+    static constexpr std::size_t level_shift(std::size_t level)
+    {
+        return level0_bits + (level - 1) * level_bits;
+    }
+
+    std::uint64_t elapsed_ticks(const time_point& tp) const
+    {
+        if (tp <= origin_)
+            return 0;
+        return static_cast<std::uint64_t>((tp - origin_) / tick_);
+    }
+
+    void schedule(entry& e, const time_point& now)
+    {
+        auto when = (std::min)(e.expiry(), now + revisit_);
+        // round up, an entry must never be looked at before its deadline.
+        auto tick = elapsed_ticks(when);
+        if (origin_ + static_cast<duration::rep>(tick) * tick_ < when)
+            ++tick;
+        link(e, (std::max)(tick, current_ + 1));
+    }
+
+    void link(entry& e, std::uint64_t tick)
+    {
+        entry** slot = nullptr;
+        auto delta   = tick - current_;
+        if (delta <= level0_mask) {
+            slot = &level0_[tick & level0_mask];
+        }
+        else {
+            std::size_t level = 1;
+            while (level + 1 < levels && delta >> level_shift(level + 1) != 0)
+                ++level;
+
+            auto horizon = std::uint64_t(1) << (level_shift(level) + level_bits);
+            if (delta >= horizon)
+                tick = current_ + horizon - 1;
+            slot = &levels_[level - 1][(tick >> level_shift(level)) & level_mask];
+        }
+
+        e.tick_ = tick;
+        e.slot_ = slot;
+        e.prev_ = nullptr;
+        e.next_ = *slot;
+        if (*slot)
+            (*slot)->prev_ = &e;
+        *slot = &e;
+    }
+
+    void unlink(entry& e) noexcept
+    {
+        if (e.prev_)
+            e.prev_->next_ = e.next_;
+        else
+            *e.slot_ = e.next_;
+        if (e.next_)
+            e.next_->prev_ = e.prev_;
+
+        e.prev_ = nullptr;
+        e.next_ = nullptr;
+        e.slot_ = nullptr;
+    }
+
+    void cascade(std::size_t level)
+    {
+        auto index = (current_ >> level_shift(level)) & level_mask;
+        if (index == 0 && level + 1 < levels)
+            cascade(level + 1);
+
+        auto& head  = levels_[level - 1][index];
+        entry* list = head;
+        head        = nullptr;
+        while (list) {
+            entry& e = *list;
+            list     = e.next_;
+            link(e, e.tick_);
+        }
+    }
+
+private:
+    duration tick_;
+    duration revisit_;
+    time_point origin_;
+
+    std::uint64_t current_ = 0;
+    std::size_t size_      = 0;
+
+    std::array<entry*, (1u << level0_bits)> level0_ {};
+    std::array<std::array<entry*, (1u << level_bits)>, levels - 1> levels_ {};
+};
+
+} // namespace httplib::util